@@ -0,0 +1,165 @@
+// bench_ffi.c — microbenchmark for the libffi call paths in csrc/ffi_helpers.c.
+//
+// Compares omni_ffi_call (ffi_prep_cif on every call) against
+// omni_ffi_prep + omni_ffi_call_prepared (cif built once per binding),
+// calling clib/mathutils.c functions the way prim_ffi_bound_call does.
+// Also compares a heap-allocating C shim for point_midpoint against the
+// by-value struct return (omni_ffi_struct_type + omni_ffi_prep_ex).
+//
+// Usage:
+//   make -C bench ffi        # build and run
+//   ./bench/bench_ffi [iterations]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "../clib/mathutils.h"
+
+int omni_ffi_call(void* fn_ptr, int nargs, int* arg_types, void** arg_values,
+                  int ret_type, void* ret_value);
+void* omni_ffi_prep(int nargs, int* arg_types, int ret_type);
+int omni_ffi_call_prepared(void* prep, void* fn_ptr, void** arg_values, void* ret_value);
+void omni_ffi_prep_free(void* prep);
+void* omni_ffi_prep_ex(int nargs, int* arg_types, void** struct_types,
+                       int ret_type, void* ret_struct);
+void* omni_ffi_struct_type(int nfields, int* field_types, size_t* offsets, size_t* size);
+
+enum { OMNI_FFI_INT = 1, OMNI_FFI_DOUBLE = 2, OMNI_FFI_PTR = 3, OMNI_FFI_STRUCT = 5 };
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static void report(const char* name, long iters, double secs) {
+    printf("  %-28s %10.2f Mcalls/s  (%6.1f ns/call)\n",
+           name, (double)iters / secs / 1e6, secs * 1e9 / (double)iters);
+}
+
+// Both variants pass int64 storage for INT args, matching the C3 side.
+static void bench_add(long iters) {
+    int types[2] = { OMNI_FFI_INT, OMNI_FFI_INT };
+    int64_t a = 0, b = 1, ret = 0;
+    void* values[2] = { &a, &b };
+    int64_t check = 0;
+
+    double t0 = now_sec();
+    for (long i = 0; i < iters; i++) {
+        a = i & 0xffff;
+        omni_ffi_call((void*)&add, 2, types, values, OMNI_FFI_INT, &ret);
+        check += ret;
+    }
+    double unprepared = now_sec() - t0;
+
+    void* prep = omni_ffi_prep(2, types, OMNI_FFI_INT);
+    if (prep == NULL) { fprintf(stderr, "omni_ffi_prep failed\n"); exit(1); }
+    t0 = now_sec();
+    for (long i = 0; i < iters; i++) {
+        a = i & 0xffff;
+        omni_ffi_call_prepared(prep, (void*)&add, values, &ret);
+        check -= ret;
+    }
+    double prepared = now_sec() - t0;
+    omni_ffi_prep_free(prep);
+
+    printf("add(int32, int32) -> int32\n");
+    report("omni_ffi_call", iters, unprepared);
+    report("omni_ffi_call_prepared", iters, prepared);
+    printf("  speedup: %.2fx%s\n", unprepared / prepared, check != 0 ? "  (result mismatch!)" : "");
+}
+
+static void bench_power(long iters) {
+    int types[2] = { OMNI_FFI_DOUBLE, OMNI_FFI_INT };
+    double base = 1.0001, ret = 0.0;
+    int64_t exp = 3;
+    void* values[2] = { &base, &exp };
+    double sink_unprepared = 0.0, sink_prepared = 0.0;
+
+    double t0 = now_sec();
+    for (long i = 0; i < iters; i++) {
+        omni_ffi_call((void*)&power, 2, types, values, OMNI_FFI_DOUBLE, &ret);
+        sink_unprepared += ret;
+    }
+    double unprepared = now_sec() - t0;
+
+    void* prep = omni_ffi_prep(2, types, OMNI_FFI_DOUBLE);
+    if (prep == NULL) { fprintf(stderr, "omni_ffi_prep failed\n"); exit(1); }
+    t0 = now_sec();
+    for (long i = 0; i < iters; i++) {
+        omni_ffi_call_prepared(prep, (void*)&power, values, &ret);
+        sink_prepared += ret;
+    }
+    double prepared = now_sec() - t0;
+    omni_ffi_prep_free(prep);
+
+    printf("power(double, int32) -> double\n");
+    report("omni_ffi_call", iters, unprepared);
+    report("omni_ffi_call_prepared", iters, prepared);
+    printf("  speedup: %.2fx%s\n", unprepared / prepared, sink_unprepared != sink_prepared ? "  (result mismatch!)" : "");
+}
+
+// The pre-struct workaround: a shim returns a malloc'd Point, and the caller
+// frees it after reading the fields.
+static Point* point_midpoint_shim(Point* a, Point* b) {
+    Point* out = (Point*)malloc(sizeof(Point));
+    *out = point_midpoint(a, b);
+    return out;
+}
+
+static void bench_midpoint(long iters) {
+    Point pa = { 0.0, 0.0 }, pb = { 2.0, 4.0 };
+    Point* a = &pa;
+    Point* b = &pb;
+    void* values[2] = { &a, &b };
+    int ptr_types[2] = { OMNI_FFI_PTR, OMNI_FFI_PTR };
+    double sink_shim = 0.0, sink_struct = 0.0;
+
+    void* prep = omni_ffi_prep(2, ptr_types, OMNI_FFI_PTR);
+    if (prep == NULL) { fprintf(stderr, "omni_ffi_prep failed\n"); exit(1); }
+    double t0 = now_sec();
+    for (long i = 0; i < iters; i++) {
+        pb.x = (double)(i & 0xff);
+        Point* ret = NULL;
+        omni_ffi_call_prepared(prep, (void*)&point_midpoint_shim, values, &ret);
+        sink_shim += ret->x + ret->y;
+        free(ret);
+    }
+    double shim = now_sec() - t0;
+    omni_ffi_prep_free(prep);
+
+    int field_types[2] = { OMNI_FFI_DOUBLE, OMNI_FFI_DOUBLE };
+    size_t offsets[2], size = 0;
+    void* point_type = omni_ffi_struct_type(2, field_types, offsets, &size);
+    if (point_type == NULL || size != sizeof(Point)) { fprintf(stderr, "omni_ffi_struct_type failed\n"); exit(1); }
+    prep = omni_ffi_prep_ex(2, ptr_types, NULL, OMNI_FFI_STRUCT, point_type);
+    if (prep == NULL) { fprintf(stderr, "omni_ffi_prep_ex failed\n"); exit(1); }
+    t0 = now_sec();
+    for (long i = 0; i < iters; i++) {
+        pb.x = (double)(i & 0xff);
+        Point ret;
+        omni_ffi_call_prepared(prep, (void*)&point_midpoint, values, &ret);
+        sink_struct += ret.x + ret.y;
+    }
+    double by_value = now_sec() - t0;
+    omni_ffi_prep_free(prep);
+
+    printf("point_midpoint(Point*, Point*) -> Point\n");
+    report("malloc'd shim + free", iters, shim);
+    report("struct by value", iters, by_value);
+    printf("  speedup: %.2fx%s\n", shim / by_value, sink_shim != sink_struct ? "  (result mismatch!)" : "");
+}
+
+int main(int argc, char** argv) {
+    long iters = argc > 1 ? atol(argv[1]) : 5000000;
+    if (iters <= 0) iters = 5000000;
+    printf("FFI call benchmark (%ld iterations)\n\n", iters);
+    bench_add(iters);
+    printf("\n");
+    bench_power(iters);
+    printf("\n");
+    bench_midpoint(iters);
+    return 0;
+}
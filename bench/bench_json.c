@@ -0,0 +1,141 @@
+// bench_json.c — microbenchmark for the yyjson wrappers in csrc/json_helpers.c.
+//
+// Parses a generated document of N records with omni_yyjson_read (malloc'd
+// doc, what json-doc uses) and omni_yyjson_read_scratch (arena doc, what
+// json-parse uses), walks it through the omni_yyjson_* accessors the way
+// json.c3 converts to Omni values, and writes it back with yyjson_write,
+// the layout json.c3's direct emitter reproduces.
+//
+// Usage:
+//   make -C bench json       # build and run
+//   ./bench/bench_json [records] [passes]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <yyjson.h>
+
+yyjson_doc* omni_yyjson_read(const char* dat, size_t len);
+yyjson_doc* omni_yyjson_read_scratch(const char* dat, size_t len);
+void omni_yyjson_doc_release(yyjson_doc* doc);
+void omni_yyjson_doc_free(yyjson_doc* doc);
+yyjson_val* omni_yyjson_doc_get_root(yyjson_doc* doc);
+int omni_yyjson_is_int(yyjson_val* val);
+int omni_yyjson_is_real(yyjson_val* val);
+int omni_yyjson_is_str(yyjson_val* val);
+int omni_yyjson_is_arr(yyjson_val* val);
+int omni_yyjson_is_obj(yyjson_val* val);
+long long omni_yyjson_get_sint(yyjson_val* val);
+double omni_yyjson_get_real(yyjson_val* val);
+size_t omni_yyjson_get_len(yyjson_val* val);
+size_t omni_yyjson_arr_size(yyjson_val* arr);
+yyjson_val* omni_yyjson_arr_get_first(yyjson_val* arr);
+size_t omni_yyjson_obj_size(yyjson_val* obj);
+yyjson_val* omni_yyjson_obj_get_first(yyjson_val* obj);
+yyjson_val* omni_yyjson_next(yyjson_val* val);
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static void report(const char* name, long passes, size_t bytes, double secs) {
+    printf("  %-28s %10.2f MB/s  (%8.1f us/doc)\n",
+           name, (double)bytes * (double)passes / secs / 1e6, secs * 1e6 / (double)passes);
+}
+
+// [{"id":0,"name":"item-0","score":0.5,"tags":["a","b"],"ok":true}, ...]
+static char* make_document(long records, size_t* len) {
+    size_t cap = (size_t)records * 96 + 16;
+    char* buf = malloc(cap);
+    if (!buf) return NULL;
+    size_t n = 0;
+    buf[n++] = '[';
+    for (long i = 0; i < records; i++) {
+        n += (size_t)snprintf(buf + n, cap - n,
+                              "%s{\"id\":%ld,\"name\":\"item-%ld\",\"score\":%.1f,\"tags\":[\"a\",\"b\"],\"ok\":true}",
+                              i ? "," : "", i, i, (double)i * 0.5);
+    }
+    buf[n++] = ']';
+    buf[n] = 0;
+    *len = n;
+    return buf;
+}
+
+// Visit every value the way json.c3 builds Omni values; returns a checksum.
+static double walk(yyjson_val* v) {
+    if (omni_yyjson_is_int(v)) return (double)omni_yyjson_get_sint(v);
+    if (omni_yyjson_is_real(v)) return omni_yyjson_get_real(v);
+    if (omni_yyjson_is_str(v)) return (double)omni_yyjson_get_len(v);
+    double sum = 0.0;
+    if (omni_yyjson_is_arr(v)) {
+        size_t n = omni_yyjson_arr_size(v);
+        yyjson_val* e = omni_yyjson_arr_get_first(v);
+        for (size_t i = 0; i < n; i++, e = omni_yyjson_next(e)) sum += walk(e);
+    } else if (omni_yyjson_is_obj(v)) {
+        size_t n = omni_yyjson_obj_size(v);
+        yyjson_val* k = omni_yyjson_obj_get_first(v);
+        for (size_t i = 0; i < n; i++) {
+            yyjson_val* val = k + 1;
+            sum += (double)omni_yyjson_get_len(k) + walk(val);
+            k = omni_yyjson_next(val);
+        }
+    }
+    return sum;
+}
+
+int main(int argc, char** argv) {
+    long records = argc > 1 ? atol(argv[1]) : 1000;
+    long passes = argc > 2 ? atol(argv[2]) : 2000;
+    if (records <= 0) records = 1000;
+    if (passes <= 0) passes = 2000;
+
+    size_t len = 0;
+    char* text = make_document(records, &len);
+    if (!text) { fprintf(stderr, "allocation failed\n"); return 1; }
+    printf("json_helpers: %ld records, %zu bytes x %ld passes\n\n", records, len, passes);
+
+    double t0 = now_sec();
+    for (long p = 0; p < passes; p++) {
+        yyjson_doc* doc = omni_yyjson_read(text, len);
+        if (!doc) { fprintf(stderr, "parse failed\n"); return 1; }
+        omni_yyjson_doc_free(doc);
+    }
+    report("omni_yyjson_read (malloc)", passes, len, now_sec() - t0);
+
+    t0 = now_sec();
+    for (long p = 0; p < passes; p++) {
+        yyjson_doc* doc = omni_yyjson_read_scratch(text, len);
+        if (!doc) { fprintf(stderr, "parse failed\n"); return 1; }
+        omni_yyjson_doc_release(doc);
+    }
+    report("omni_yyjson_read_scratch", passes, len, now_sec() - t0);
+
+    yyjson_doc* doc = omni_yyjson_read(text, len);
+    if (!doc) { fprintf(stderr, "parse failed\n"); return 1; }
+    yyjson_val* root = omni_yyjson_doc_get_root(doc);
+    double sink = 0.0;
+    t0 = now_sec();
+    for (long p = 0; p < passes; p++) sink += walk(root);
+    report("walk accessors", passes, len, now_sec() - t0);
+
+    size_t out_len = 0;
+    t0 = now_sec();
+    for (long p = 0; p < passes; p++) {
+        char* out = yyjson_write(doc, 0, &out_len);
+        if (!out) { fprintf(stderr, "write failed\n"); return 1; }
+        free(out);
+    }
+    report("yyjson_write (emit)", passes, out_len, now_sec() - t0);
+    char* out = yyjson_write(doc, 0, &out_len);
+    int same = out && out_len == len && memcmp(text, out, len) == 0;
+    free(out);
+
+    printf("\n  round trip %s  (checksum %.6g)\n", same ? "identical" : "differs", sink);
+    omni_yyjson_doc_free(doc);
+    free(text);
+    return 0;
+}
@@ -0,0 +1,107 @@
+// bench_mathutils.c — scalar vs vector kernels in clib/mathutils.c.
+//
+// Runs each array/batch entry point with the scalar kernels pinned, then
+// with the dispatched ones (AVX2 or NEON), and checks the results agree.
+//
+// Usage:
+//   make -C bench mathutils   # build and run
+//   ./bench/bench_mathutils [elements] [passes]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+#include <time.h>
+
+#include "../clib/mathutils.h"
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static void report(const char* name, long n, long passes, double scalar, double vector, int ok) {
+    double elems = (double)n * (double)passes;
+    printf("  %-22s scalar %8.2f Gelem/s  vector %8.2f Gelem/s  speedup %5.2fx%s\n",
+           name, elems / scalar / 1e9, elems / vector / 1e9, scalar / vector,
+           ok ? "" : "  (result mismatch!)");
+}
+
+// Time `passes` runs of a kernel body once per kernel set.
+#define BENCH(name, body, result_t, result, compare)                       \
+    do {                                                                   \
+        result_t r_s = 0, r_v = 0;                                         \
+        mathutils_use_simd(0);                                             \
+        double t0 = now_sec();                                             \
+        for (long p = 0; p < passes; p++) { body; r_s = result; }          \
+        double scalar = now_sec() - t0;                                    \
+        mathutils_use_simd(1);                                             \
+        t0 = now_sec();                                                    \
+        for (long p = 0; p < passes; p++) { body; r_v = result; }          \
+        double vector = now_sec() - t0;                                    \
+        report(name, n, passes, scalar, vector, compare);                  \
+    } while (0)
+
+int main(int argc, char** argv) {
+    long n = argc > 1 ? atol(argv[1]) : 1 << 16;
+    long passes = argc > 2 ? atol(argv[2]) : 2000;
+    if (n <= 0) n = 1 << 16;
+    if (passes <= 0) passes = 2000;
+
+    mathutils_use_simd(1);
+    printf("mathutils kernels: %s (%ld elements x %ld passes)\n\n", mathutils_simd_level(), n, passes);
+
+    int32_t* i32 = malloc((size_t)n * sizeof(int32_t));
+    int64_t* i64 = malloc((size_t)n * sizeof(int64_t));
+    double* f64 = malloc((size_t)n * sizeof(double));
+    double* xa = malloc((size_t)n * sizeof(double));
+    double* ya = malloc((size_t)n * sizeof(double));
+    double* xb = malloc((size_t)n * sizeof(double));
+    double* yb = malloc((size_t)n * sizeof(double));
+    double* out = malloc((size_t)n * sizeof(double));
+    double* out_y = malloc((size_t)n * sizeof(double));
+    if (!i32 || !i64 || !f64 || !xa || !ya || !xb || !yb || !out || !out_y) {
+        fprintf(stderr, "allocation failed\n");
+        return 1;
+    }
+    srand(42);
+    for (long i = 0; i < n; i++) {
+        i32[i] = rand() - RAND_MAX / 2;
+        i64[i] = (int64_t)rand() * 4096;
+        f64[i] = (double)rand() / RAND_MAX;
+        xa[i] = (double)rand() / 1000.0;
+        ya[i] = (double)rand() / 1000.0;
+        xb[i] = (double)rand() / 1000.0;
+        yb[i] = (double)rand() / 1000.0;
+    }
+
+    BENCH("sum_array64", , int64_t, sum_array64(i32, n), r_s == r_v);
+    BENCH("sum_array_i64", , int64_t, sum_array_i64(i64, n), r_s == r_v);
+    BENCH("sum_array_f64", , double, sum_array_f64(f64, n), fabs(r_s - r_v) <= 1e-9 * fabs(r_s));
+    // scale by 1 keeps the input stable across passes
+    BENCH("scale_array", scale_array(i32, (int32_t)n, 1), int32_t, i32[n - 1], r_s == r_v);
+    BENCH("scale_array_f64", scale_array_f64(f64, n, 1.0), double, f64[n - 1], r_s == r_v);
+    BENCH("point_distance_batch", point_distance_batch(xa, ya, xb, yb, out, n), double, out[n - 1], r_s == r_v);
+    BENCH("point_midpoint_batch", point_midpoint_batch(xa, ya, xb, yb, out, out_y, n), double,
+          out[n - 1] + out_y[n - 1], r_s == r_v);
+
+    // Per-element calls vs one batch call
+    double t0 = now_sec();
+    double sink = 0.0;
+    for (long p = 0; p < passes; p++) {
+        for (long i = 0; i < n; i++) {
+            Point a = { xa[i], ya[i] }, b = { xb[i], yb[i] };
+            sink += point_distance(&a, &b);
+        }
+    }
+    double single = now_sec() - t0;
+    t0 = now_sec();
+    for (long p = 0; p < passes; p++) point_distance_batch(xa, ya, xb, yb, out, n);
+    double batch = now_sec() - t0;
+    printf("\n  point_distance x n vs batch: %.2fx  (checksum %.3g)\n", single / batch, sink);
+
+    free(i32); free(i64); free(f64);
+    free(xa); free(ya); free(xb); free(yb); free(out); free(out_y);
+    return 0;
+}
@@ -1,7 +1,16 @@
 #include "mathutils.h"
 #include <math.h>
+#include <stdlib.h>
 #include <string.h>
 
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define MATHUTILS_X86 1
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define MATHUTILS_NEON 1
+#endif
+
 int32_t add(int32_t a, int32_t b) {
     return a + b;
 }
@@ -14,18 +23,345 @@ double power(double base, int32_t exp) {
     return pow(base, (double)exp);
 }
 
-int32_t sum_array(int32_t* arr, int32_t len) {
-    int32_t sum = 0;
-    for (int32_t i = 0; i < len; i++) {
-        sum += arr[i];
+// ============================================================================
+// Kernels
+//
+// Each kernel has a scalar version and, where the target has one, a vector
+// version; the table is picked once at first use (see kernels()). Integer
+// kernels give identical results on every path. Float sums may differ in the
+// last bits because the vector lanes add in a different order; the
+// elementwise kernels (scale, distance, midpoint) are bit-identical.
+// ============================================================================
+
+typedef struct {
+    const char* name;
+    int64_t (*sum_i32)(const int32_t* arr, int64_t len);
+    int64_t (*sum_i64)(const int64_t* arr, int64_t len);
+    double  (*sum_f64)(const double* arr, int64_t len);
+    void    (*scale_i32)(int32_t* arr, int64_t len, int32_t factor);
+    void    (*scale_f64)(double* arr, int64_t len, double factor);
+    void    (*distance)(const double* xa, const double* ya, const double* xb, const double* yb,
+                        double* out, int64_t n);
+    void    (*midpoint)(const double* xa, const double* ya, const double* xb, const double* yb,
+                        double* out_x, double* out_y, int64_t n);
+} mathutils_kernels;
+
+static int64_t sum_i32_scalar(const int32_t* arr, int64_t len) {
+    int64_t sum = 0;
+    for (int64_t i = 0; i < len; i++) sum += arr[i];
+    return sum;
+}
+
+static int64_t sum_i64_scalar(const int64_t* arr, int64_t len) {
+    uint64_t sum = 0;  // wraps like the vector lanes instead of overflowing
+    for (int64_t i = 0; i < len; i++) sum += (uint64_t)arr[i];
+    return (int64_t)sum;
+}
+
+static double sum_f64_scalar(const double* arr, int64_t len) {
+    double sum = 0.0;
+    for (int64_t i = 0; i < len; i++) sum += arr[i];
+    return sum;
+}
+
+static void scale_i32_scalar(int32_t* arr, int64_t len, int32_t factor) {
+    for (int64_t i = 0; i < len; i++) arr[i] = (int32_t)((uint32_t)arr[i] * (uint32_t)factor);
+}
+
+static void scale_f64_scalar(double* arr, int64_t len, double factor) {
+    for (int64_t i = 0; i < len; i++) arr[i] *= factor;
+}
+
+static void distance_scalar(const double* xa, const double* ya, const double* xb, const double* yb,
+                            double* out, int64_t n) {
+    for (int64_t i = 0; i < n; i++) {
+        double dx = xb[i] - xa[i];
+        double dy = yb[i] - ya[i];
+        out[i] = sqrt(dx * dx + dy * dy);
+    }
+}
+
+static void midpoint_scalar(const double* xa, const double* ya, const double* xb, const double* yb,
+                            double* out_x, double* out_y, int64_t n) {
+    for (int64_t i = 0; i < n; i++) {
+        out_x[i] = (xa[i] + xb[i]) / 2.0;
+        out_y[i] = (ya[i] + yb[i]) / 2.0;
+    }
+}
+
+// The midpoint kernels average x then y one block at a time. Interleaving both
+// coordinates keeps six streams in flight, more than the prefetchers track.
+// This way each block reads two streams and writes one, and stays in L1.
+#define MIDPOINT_BLOCK 1024
+
+static const mathutils_kernels k_scalar = {
+    "scalar", sum_i32_scalar, sum_i64_scalar, sum_f64_scalar,
+    scale_i32_scalar, scale_f64_scalar, distance_scalar, midpoint_scalar,
+};
+
+#if MATHUTILS_X86
+// AVX2 kernels: compiled for AVX2 via the target attribute so the rest of the
+// library keeps the baseline ISA; only reached when the CPU reports AVX2.
+#define AVX2 __attribute__((target("avx2")))
+
+AVX2 static int64_t hsum_epi64(__m256i v) {
+    __m128i s = _mm_add_epi64(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+    return _mm_cvtsi128_si64(s) + _mm_extract_epi64(s, 1);
+}
+
+AVX2 static double hsum_pd(__m256d v) {
+    __m128d s = _mm_add_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+    return _mm_cvtsd_f64(_mm_add_sd(s, _mm_unpackhi_pd(s, s)));
+}
+
+AVX2 static int64_t sum_i32_avx2(const int32_t* arr, int64_t len) {
+    __m256i acc0 = _mm256_setzero_si256();
+    __m256i acc1 = _mm256_setzero_si256();
+    int64_t i = 0;
+    for (; i + 8 <= len; i += 8) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(arr + i));
+        acc0 = _mm256_add_epi64(acc0, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(v)));
+        acc1 = _mm256_add_epi64(acc1, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(v, 1)));
     }
+    int64_t sum = hsum_epi64(_mm256_add_epi64(acc0, acc1));
+    for (; i < len; i++) sum += arr[i];
     return sum;
 }
 
-void scale_array(int32_t* arr, int32_t len, int32_t factor) {
-    for (int32_t i = 0; i < len; i++) {
-        arr[i] *= factor;
+AVX2 static int64_t sum_i64_avx2(const int64_t* arr, int64_t len) {
+    __m256i acc0 = _mm256_setzero_si256();
+    __m256i acc1 = _mm256_setzero_si256();
+    int64_t i = 0;
+    for (; i + 8 <= len; i += 8) {
+        acc0 = _mm256_add_epi64(acc0, _mm256_loadu_si256((const __m256i*)(arr + i)));
+        acc1 = _mm256_add_epi64(acc1, _mm256_loadu_si256((const __m256i*)(arr + i + 4)));
+    }
+    uint64_t sum = (uint64_t)hsum_epi64(_mm256_add_epi64(acc0, acc1));
+    for (; i < len; i++) sum += (uint64_t)arr[i];
+    return (int64_t)sum;
+}
+
+AVX2 static double sum_f64_avx2(const double* arr, int64_t len) {
+    __m256d acc0 = _mm256_setzero_pd();
+    __m256d acc1 = _mm256_setzero_pd();
+    int64_t i = 0;
+    for (; i + 8 <= len; i += 8) {
+        acc0 = _mm256_add_pd(acc0, _mm256_loadu_pd(arr + i));
+        acc1 = _mm256_add_pd(acc1, _mm256_loadu_pd(arr + i + 4));
+    }
+    double sum = hsum_pd(_mm256_add_pd(acc0, acc1));
+    for (; i < len; i++) sum += arr[i];
+    return sum;
+}
+
+AVX2 static void scale_i32_avx2(int32_t* arr, int64_t len, int32_t factor) {
+    __m256i f = _mm256_set1_epi32(factor);
+    int64_t i = 0;
+    for (; i + 8 <= len; i += 8) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(arr + i));
+        _mm256_storeu_si256((__m256i*)(arr + i), _mm256_mullo_epi32(v, f));
+    }
+    scale_i32_scalar(arr + i, len - i, factor);
+}
+
+AVX2 static void scale_f64_avx2(double* arr, int64_t len, double factor) {
+    __m256d f = _mm256_set1_pd(factor);
+    int64_t i = 0;
+    for (; i + 4 <= len; i += 4) _mm256_storeu_pd(arr + i, _mm256_mul_pd(_mm256_loadu_pd(arr + i), f));
+    scale_f64_scalar(arr + i, len - i, factor);
+}
+
+AVX2 static void distance_avx2(const double* xa, const double* ya, const double* xb, const double* yb,
+                               double* out, int64_t n) {
+    int64_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d dx = _mm256_sub_pd(_mm256_loadu_pd(xb + i), _mm256_loadu_pd(xa + i));
+        __m256d dy = _mm256_sub_pd(_mm256_loadu_pd(yb + i), _mm256_loadu_pd(ya + i));
+        __m256d d2 = _mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy));
+        _mm256_storeu_pd(out + i, _mm256_sqrt_pd(d2));
     }
+    distance_scalar(xa + i, ya + i, xb + i, yb + i, out + i, n - i);
+}
+
+// out[i] = (a[i] + b[i]) * 0.5, which rounds exactly like the scalar / 2.0
+AVX2 static void average_avx2(const double* a, const double* b, double* out, int64_t n) {
+    __m256d half = _mm256_set1_pd(0.5);
+    int64_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256d lo = _mm256_add_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i));
+        __m256d hi = _mm256_add_pd(_mm256_loadu_pd(a + i + 4), _mm256_loadu_pd(b + i + 4));
+        _mm256_storeu_pd(out + i, _mm256_mul_pd(lo, half));
+        _mm256_storeu_pd(out + i + 4, _mm256_mul_pd(hi, half));
+    }
+    for (; i < n; i++) out[i] = (a[i] + b[i]) / 2.0;
+}
+
+AVX2 static void midpoint_avx2(const double* xa, const double* ya, const double* xb, const double* yb,
+                               double* out_x, double* out_y, int64_t n) {
+    for (int64_t i = 0; i < n; i += MIDPOINT_BLOCK) {
+        int64_t m = n - i < MIDPOINT_BLOCK ? n - i : MIDPOINT_BLOCK;
+        average_avx2(xa + i, xb + i, out_x + i, m);
+        average_avx2(ya + i, yb + i, out_y + i, m);
+    }
+}
+
+static const mathutils_kernels k_avx2 = {
+    "avx2", sum_i32_avx2, sum_i64_avx2, sum_f64_avx2,
+    scale_i32_avx2, scale_f64_avx2, distance_avx2, midpoint_avx2,
+};
+#endif
+
+#if MATHUTILS_NEON
+// NEON is part of the AArch64 baseline, so these need no runtime check.
+static int64_t sum_i32_neon(const int32_t* arr, int64_t len) {
+    int64x2_t acc0 = vdupq_n_s64(0);
+    int64x2_t acc1 = vdupq_n_s64(0);
+    int64_t i = 0;
+    for (; i + 8 <= len; i += 8) {
+        acc0 = vpadalq_s32(acc0, vld1q_s32(arr + i));
+        acc1 = vpadalq_s32(acc1, vld1q_s32(arr + i + 4));
+    }
+    int64_t sum = vaddvq_s64(vaddq_s64(acc0, acc1));
+    for (; i < len; i++) sum += arr[i];
+    return sum;
+}
+
+static int64_t sum_i64_neon(const int64_t* arr, int64_t len) {
+    int64x2_t acc0 = vdupq_n_s64(0);
+    int64x2_t acc1 = vdupq_n_s64(0);
+    int64_t i = 0;
+    for (; i + 4 <= len; i += 4) {
+        acc0 = vaddq_s64(acc0, vld1q_s64(arr + i));
+        acc1 = vaddq_s64(acc1, vld1q_s64(arr + i + 2));
+    }
+    uint64_t sum = (uint64_t)vaddvq_s64(vaddq_s64(acc0, acc1));
+    for (; i < len; i++) sum += (uint64_t)arr[i];
+    return (int64_t)sum;
+}
+
+static double sum_f64_neon(const double* arr, int64_t len) {
+    float64x2_t acc0 = vdupq_n_f64(0.0);
+    float64x2_t acc1 = vdupq_n_f64(0.0);
+    int64_t i = 0;
+    for (; i + 4 <= len; i += 4) {
+        acc0 = vaddq_f64(acc0, vld1q_f64(arr + i));
+        acc1 = vaddq_f64(acc1, vld1q_f64(arr + i + 2));
+    }
+    double sum = vaddvq_f64(vaddq_f64(acc0, acc1));
+    for (; i < len; i++) sum += arr[i];
+    return sum;
+}
+
+static void scale_i32_neon(int32_t* arr, int64_t len, int32_t factor) {
+    int32x4_t f = vdupq_n_s32(factor);
+    int64_t i = 0;
+    for (; i + 4 <= len; i += 4) vst1q_s32(arr + i, vmulq_s32(vld1q_s32(arr + i), f));
+    scale_i32_scalar(arr + i, len - i, factor);
+}
+
+static void scale_f64_neon(double* arr, int64_t len, double factor) {
+    float64x2_t f = vdupq_n_f64(factor);
+    int64_t i = 0;
+    for (; i + 2 <= len; i += 2) vst1q_f64(arr + i, vmulq_f64(vld1q_f64(arr + i), f));
+    scale_f64_scalar(arr + i, len - i, factor);
+}
+
+static void distance_neon(const double* xa, const double* ya, const double* xb, const double* yb,
+                          double* out, int64_t n) {
+    int64_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        float64x2_t dx = vsubq_f64(vld1q_f64(xb + i), vld1q_f64(xa + i));
+        float64x2_t dy = vsubq_f64(vld1q_f64(yb + i), vld1q_f64(ya + i));
+        // Separate mul/add (no vfmaq) to round exactly like the scalar path
+        float64x2_t d2 = vaddq_f64(vmulq_f64(dx, dx), vmulq_f64(dy, dy));
+        vst1q_f64(out + i, vsqrtq_f64(d2));
+    }
+    distance_scalar(xa + i, ya + i, xb + i, yb + i, out + i, n - i);
+}
+
+static void average_neon(const double* a, const double* b, double* out, int64_t n) {
+    float64x2_t half = vdupq_n_f64(0.5);
+    int64_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        vst1q_f64(out + i, vmulq_f64(vaddq_f64(vld1q_f64(a + i), vld1q_f64(b + i)), half));
+        vst1q_f64(out + i + 2, vmulq_f64(vaddq_f64(vld1q_f64(a + i + 2), vld1q_f64(b + i + 2)), half));
+    }
+    for (; i < n; i++) out[i] = (a[i] + b[i]) / 2.0;
+}
+
+static void midpoint_neon(const double* xa, const double* ya, const double* xb, const double* yb,
+                          double* out_x, double* out_y, int64_t n) {
+    for (int64_t i = 0; i < n; i += MIDPOINT_BLOCK) {
+        int64_t m = n - i < MIDPOINT_BLOCK ? n - i : MIDPOINT_BLOCK;
+        average_neon(xa + i, xb + i, out_x + i, m);
+        average_neon(ya + i, yb + i, out_y + i, m);
+    }
+}
+
+static const mathutils_kernels k_neon = {
+    "neon", sum_i32_neon, sum_i64_neon, sum_f64_neon,
+    scale_i32_neon, scale_f64_neon, distance_neon, midpoint_neon,
+};
+#endif
+
+static const mathutils_kernels* g_kernels = NULL;
+
+static const mathutils_kernels* best_kernels(void) {
+#if MATHUTILS_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return &k_avx2;
+#elif MATHUTILS_NEON
+    return &k_neon;
+#endif
+    return &k_scalar;
+}
+
+// Resolved on first call; MATHUTILS_SCALAR=1 in the environment pins the
+// scalar kernels. Racing first calls store the same pointer.
+static const mathutils_kernels* kernels(void) {
+    const mathutils_kernels* k = __atomic_load_n(&g_kernels, __ATOMIC_ACQUIRE);
+    if (k != NULL) return k;
+    const char* env = getenv("MATHUTILS_SCALAR");
+    k = (env != NULL && env[0] == '1') ? &k_scalar : best_kernels();
+    __atomic_store_n(&g_kernels, k, __ATOMIC_RELEASE);
+    return k;
+}
+
+const char* mathutils_simd_level(void) {
+    return kernels()->name;
+}
+
+void mathutils_use_simd(int enable) {
+    __atomic_store_n(&g_kernels, enable ? best_kernels() : &k_scalar, __ATOMIC_RELEASE);
+}
+
+// ============================================================================
+// Array operations
+// ============================================================================
+
+int32_t sum_array(int32_t* arr, int32_t len) {
+    // Truncating the 64-bit sum gives the wrapped 32-bit result without signed overflow
+    return (int32_t)(uint32_t)kernels()->sum_i32(arr, len);
+}
+
+void scale_array(int32_t* arr, int32_t len, int32_t factor) {
+    kernels()->scale_i32(arr, len, factor);
+}
+
+int64_t sum_array64(const int32_t* arr, int64_t len) {
+    return kernels()->sum_i32(arr, len);
+}
+
+int64_t sum_array_i64(const int64_t* arr, int64_t len) {
+    return kernels()->sum_i64(arr, len);
+}
+
+double sum_array_f64(const double* arr, int64_t len) {
+    return kernels()->sum_f64(arr, len);
+}
+
+void scale_array_f64(double* arr, int64_t len, double factor) {
+    kernels()->scale_f64(arr, len, factor);
 }
 
 int32_t string_length(const char* str) {
@@ -53,3 +389,19 @@ Point point_midpoint(Point* a, Point* b) {
     mid.y = (a->y + b->y) / 2.0;
     return mid;
 }
+
+// ============================================================================
+// Batch point operations (structure of arrays)
+// ============================================================================
+
+void point_distance_batch(const double* xs_a, const double* ys_a,
+                          const double* xs_b, const double* ys_b,
+                          double* out, int64_t n) {
+    kernels()->distance(xs_a, ys_a, xs_b, ys_b, out, n);
+}
+
+void point_midpoint_batch(const double* xs_a, const double* ys_a,
+                          const double* xs_b, const double* ys_b,
+                          double* out_x, double* out_y, int64_t n) {
+    kernels()->midpoint(xs_a, ys_a, xs_b, ys_b, out_x, out_y, n);
+}
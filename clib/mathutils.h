@@ -9,9 +9,20 @@ int32_t multiply(int32_t a, int32_t b);
 double power(double base, int32_t exp);
 
 // Array operations
-int32_t sum_array(int32_t* arr, int32_t len);
+// Vectorized (AVX2 or NEON) when the CPU supports it; see mathutils_simd_level().
+int32_t sum_array(int32_t* arr, int32_t len);   // wraps modulo 2^32
 void scale_array(int32_t* arr, int32_t len, int32_t factor);
 
+// 64-bit lengths and accumulators
+int64_t sum_array64(const int32_t* arr, int64_t len);
+int64_t sum_array_i64(const int64_t* arr, int64_t len);
+double sum_array_f64(const double* arr, int64_t len);
+void scale_array_f64(double* arr, int64_t len, double factor);
+
+// Kernel selection: "avx2", "neon" or "scalar" (MATHUTILS_SCALAR=1 forces scalar)
+const char* mathutils_simd_level(void);
+void mathutils_use_simd(int enable);
+
 // String utilities
 int32_t string_length(const char* str);
 void string_reverse(char* str);
@@ -25,4 +36,12 @@ typedef struct {
 double point_distance(Point* a, Point* b);
 Point point_midpoint(Point* a, Point* b);
 
+// Batch point operations over structure-of-arrays inputs, n points each
+void point_distance_batch(const double* xs_a, const double* ys_a,
+                          const double* xs_b, const double* ys_b,
+                          double* out, int64_t n);
+void point_midpoint_batch(const double* xs_a, const double* ys_a,
+                          const double* xs_b, const double* ys_b,
+                          double* out_x, double* out_y, int64_t n);
+
 #endif
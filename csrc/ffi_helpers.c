@@ -2,6 +2,8 @@
 // Reason: libffi uses C structs (ffi_type, ffi_cif) that are hard to declare in C3.
 
 #include <ffi.h>
+#include <stdlib.h>
+#include <string.h>
 
 // Type codes matching Omni's FFI type enum (must stay in sync with value.c3 FfiTypeTag)
 enum {
@@ -10,6 +12,9 @@ enum {
     OMNI_FFI_DOUBLE = 2,
     OMNI_FFI_PTR    = 3,  // pointer (includes String, Ptr)
     OMNI_FFI_BOOL   = 4,
+    OMNI_FFI_STRUCT = 5,  // by-value struct; descriptor from omni_ffi_struct_type
+    OMNI_FFI_INT32  = 6,  // C int
+    OMNI_FFI_FLOAT  = 7,  // C float; record fields only
 };
 
 static ffi_type* omni_to_ffi_type(int t) {
@@ -19,10 +24,48 @@ static ffi_type* omni_to_ffi_type(int t) {
         case OMNI_FFI_DOUBLE: return &ffi_type_double;
         case OMNI_FFI_PTR:    return &ffi_type_pointer;
         case OMNI_FFI_BOOL:   return &ffi_type_sint64;
+        case OMNI_FFI_INT32:  return &ffi_type_sint64;  // as a param, a full word like INT
         default:              return &ffi_type_pointer;
     }
 }
 
+// Return types: an INT32 result is a C int. libffi widens a sint32 result to
+// a full ffi_arg with sign extension, which matches the JIT direct stubs;
+// reading sint64 would take the undefined upper half of the return register.
+static ffi_type* omni_to_ffi_ret_type(int t) {
+    if (t == OMNI_FFI_INT32) return &ffi_type_sint32;
+    return omni_to_ffi_type(t);
+}
+
+// Record fields take their C width: INT32 is an int, BOOL a one-byte bool,
+// FLOAT a float. Params and returns widen those to a full word instead.
+static ffi_type* omni_to_ffi_field_type(int t) {
+    switch (t) {
+        case OMNI_FFI_INT32: return &ffi_type_sint32;
+        case OMNI_FFI_BOOL:  return &ffi_type_uint8;
+        case OMNI_FFI_FLOAT: return &ffi_type_float;
+        default:             return omni_to_ffi_type(t);
+    }
+}
+
+// Arities up to this use a stack atypes array; larger ones use a per-thread
+// scratch array that grows to the widest call seen and is kept for reuse.
+#define OMNI_FFI_INLINE_ARGS 16
+
+static _Thread_local ffi_type** omni_ffi_scratch = NULL;
+static _Thread_local int omni_ffi_scratch_cap = 0;
+
+static ffi_type** omni_ffi_atypes(ffi_type** inline_atypes, int nargs) {
+    if (nargs <= OMNI_FFI_INLINE_ARGS) return inline_atypes;
+    if (nargs > omni_ffi_scratch_cap) {
+        ffi_type** grown = (ffi_type**)realloc(omni_ffi_scratch, sizeof(ffi_type*) * (size_t)nargs);
+        if (grown == NULL) return NULL;
+        omni_ffi_scratch = grown;
+        omni_ffi_scratch_cap = nargs;
+    }
+    return omni_ffi_scratch;
+}
+
 // omni_ffi_call — prepare CIF and call function via libffi.
 // fn_ptr:     dlsym'd function pointer
 // nargs:      number of arguments
@@ -33,14 +76,16 @@ static ffi_type* omni_to_ffi_type(int t) {
 // Returns: 0 on success, -1 on error
 int omni_ffi_call(void* fn_ptr, int nargs, int* arg_types, void** arg_values,
                   int ret_type, void* ret_value) {
-    if (nargs > 16) return -1;
+    if (nargs < 0) return -1;
 
     ffi_cif cif;
-    ffi_type* atypes[16];
+    ffi_type* inline_atypes[OMNI_FFI_INLINE_ARGS];
+    ffi_type** atypes = omni_ffi_atypes(inline_atypes, nargs);
+    if (atypes == NULL) return -1;
     for (int i = 0; i < nargs; i++) {
         atypes[i] = omni_to_ffi_type(arg_types[i]);
     }
-    ffi_type* rtype = omni_to_ffi_type(ret_type);
+    ffi_type* rtype = omni_to_ffi_ret_type(ret_type);
 
     ffi_status status = ffi_prep_cif(&cif, FFI_DEFAULT_ABI, (unsigned int)nargs, rtype, atypes);
     if (status != FFI_OK) return -1;
@@ -54,14 +99,16 @@ int omni_ffi_call(void* fn_ptr, int nargs, int* arg_types, void** arg_values,
 int omni_ffi_call_var(void* fn_ptr, int nargs, int fixed_count,
                       int* arg_types, void** arg_values,
                       int ret_type, void* ret_value) {
-    if (nargs > 16) return -1;
+    if (nargs < 0) return -1;
 
     ffi_cif cif;
-    ffi_type* atypes[16];
+    ffi_type* inline_atypes[OMNI_FFI_INLINE_ARGS];
+    ffi_type** atypes = omni_ffi_atypes(inline_atypes, nargs);
+    if (atypes == NULL) return -1;
     for (int i = 0; i < nargs; i++) {
         atypes[i] = omni_to_ffi_type(arg_types[i]);
     }
-    ffi_type* rtype = omni_to_ffi_type(ret_type);
+    ffi_type* rtype = omni_to_ffi_ret_type(ret_type);
 
     ffi_status status = ffi_prep_cif_var(&cif, FFI_DEFAULT_ABI,
                                           (unsigned int)fixed_count,
@@ -72,3 +119,119 @@ int omni_ffi_call_var(void* fn_ptr, int nargs, int fixed_count,
     ffi_call(&cif, (void (*)(void))fn_ptr, ret_value, arg_values);
     return 0;
 }
+
+// OmniFfiPrep — prepared call interface for a bound function.
+// The cif keeps a pointer to atypes, so both live in one allocation
+// (atypes is sized to the binding's arity).
+typedef struct OmniFfiPrep {
+    ffi_cif cif;
+    ffi_type* atypes[];
+} OmniFfiPrep;
+
+// omni_ffi_struct_type — build an ffi_type descriptor for a struct whose
+// fields are OMNI_FFI_* scalar codes, and report its C layout.
+// offsets: receives nfields byte offsets; size: receives sizeof the struct.
+// The descriptor is meant to be cached per Omni type and is never freed.
+// Returns NULL on error.
+void* omni_ffi_struct_type(int nfields, int* field_types, size_t* offsets, size_t* size) {
+    if (nfields <= 0) return NULL;
+
+    // One allocation: the ffi_type header followed by its NULL-terminated elements
+    ffi_type* st = (ffi_type*)malloc(sizeof(ffi_type) + sizeof(ffi_type*) * (size_t)(nfields + 1));
+    if (st == NULL) return NULL;
+    ffi_type** elems = (ffi_type**)(st + 1);
+    for (int i = 0; i < nfields; i++) {
+        elems[i] = omni_to_ffi_field_type(field_types[i]);
+    }
+    elems[nfields] = NULL;
+    memset(st, 0, sizeof(ffi_type));
+    st->type = FFI_TYPE_STRUCT;
+    st->elements = elems;
+
+    // Fills in st->size/alignment as a side effect
+    if (ffi_get_struct_offsets(FFI_DEFAULT_ABI, st, offsets) != FFI_OK) {
+        free(st);
+        return NULL;
+    }
+    *size = st->size;
+    return st;
+}
+
+// omni_ffi_prep_ex — like omni_ffi_prep, with struct descriptors.
+// struct_types[i] is used where arg_types[i] == OMNI_FFI_STRUCT (may be NULL
+// if there are none); ret_struct is used when ret_type == OMNI_FFI_STRUCT.
+void* omni_ffi_prep_ex(int nargs, int* arg_types, void** struct_types,
+                       int ret_type, void* ret_struct) {
+    if (nargs < 0) return NULL;
+
+    OmniFfiPrep* prep = (OmniFfiPrep*)malloc(sizeof(OmniFfiPrep) + sizeof(ffi_type*) * (size_t)nargs);
+    if (prep == NULL) return NULL;
+    for (int i = 0; i < nargs; i++) {
+        if (arg_types[i] == OMNI_FFI_STRUCT) {
+            if (struct_types == NULL || struct_types[i] == NULL) {
+                free(prep);
+                return NULL;
+            }
+            prep->atypes[i] = (ffi_type*)struct_types[i];
+        } else {
+            prep->atypes[i] = omni_to_ffi_type(arg_types[i]);
+        }
+    }
+    ffi_type* rtype;
+    if (ret_type == OMNI_FFI_STRUCT) {
+        if (ret_struct == NULL) {
+            free(prep);
+            return NULL;
+        }
+        rtype = (ffi_type*)ret_struct;
+    } else {
+        rtype = omni_to_ffi_ret_type(ret_type);
+    }
+
+    ffi_status status = ffi_prep_cif(&prep->cif, FFI_DEFAULT_ABI, (unsigned int)nargs,
+                                     rtype, prep->atypes);
+    if (status != FFI_OK) {
+        free(prep);
+        return NULL;
+    }
+    return prep;
+}
+
+// omni_ffi_prep — build the ffi_type array and run ffi_prep_cif once.
+// Returns an opaque handle for omni_ffi_call_prepared, or NULL on error.
+// The handle is owned by the caller and released with omni_ffi_prep_free.
+void* omni_ffi_prep(int nargs, int* arg_types, int ret_type) {
+    return omni_ffi_prep_ex(nargs, arg_types, NULL, ret_type, NULL);
+}
+
+// omni_ffi_call_prepared — call through a cif built by omni_ffi_prep.
+// arg_values/ret_value follow the same layout as omni_ffi_call.
+// Returns: 0 on success, -1 on error
+int omni_ffi_call_prepared(void* prep, void* fn_ptr, void** arg_values, void* ret_value) {
+    if (prep == NULL || fn_ptr == NULL) return -1;
+    ffi_call(&((OmniFfiPrep*)prep)->cif, (void (*)(void))fn_ptr, ret_value, arg_values);
+    return 0;
+}
+
+// omni_ffi_call_batch — call through a prepared cif once per row.
+// cols[j]: base of packed argument column j; strides[j]: its row stride in
+// bytes (0 broadcasts one value to every row). Row i's return value goes to
+// ret + i * ret_stride. arg_values: caller scratch for nargs pointers.
+// Returns: 0 on success, -1 on error
+int omni_ffi_call_batch(void* prep, void* fn_ptr, int nargs, size_t rows,
+                        char** cols, size_t* strides, void** arg_values,
+                        char* ret, size_t ret_stride) {
+    if (prep == NULL || fn_ptr == NULL) return -1;
+    ffi_cif* cif = &((OmniFfiPrep*)prep)->cif;
+    for (size_t i = 0; i < rows; i++) {
+        for (int j = 0; j < nargs; j++) {
+            arg_values[j] = cols[j] + i * strides[j];
+        }
+        ffi_call(cif, (void (*)(void))fn_ptr, ret + i * ret_stride, arg_values);
+    }
+    return 0;
+}
+
+void omni_ffi_prep_free(void* prep) {
+    free(prep);
+}
@@ -1,13 +1,120 @@
+#include "../third_party/arena/vmem_arena.h"
+
 #include <yyjson.h>
 #include <stdlib.h>
 #include <string.h>
 
+/* =================== Scratch allocator =================== */
+
+/*
+ * Documents that are materialized and freed within one primitive call
+ * (json-parse, json-stream-next) draw their pools from a thread-local vmem
+ * arena instead of malloc. Releasing the doc rewinds the arena, so the next
+ * parse reuses the same committed pages. Only one scratch doc is live per
+ * thread; a parse while one is live uses malloc. Long-lived docs
+ * (json-doc) always use malloc.
+ */
+#define OMNI_JSON_SCRATCH_KEEP (64u * 1024 * 1024)  /* release pages past this */
+
+static _Thread_local Arena omni_json_arena;
+static _Thread_local yyjson_doc* omni_json_scratch_doc;
+
+static void* omni_scratch_malloc(void* ctx, size_t size) {
+    return arena_alloc((Arena*)ctx, size);
+}
+
+/* Grow in place when ptr is the most recent allocation (yyjson's pools are) */
+static void* omni_scratch_realloc(void* ctx, void* ptr, size_t old_size, size_t size) {
+    Arena* a = (Arena*)ctx;
+    VMemChunk* c = a->end;
+    if (ptr && c && (char*)ptr + VMEM_ALIGN_UP(old_size, sizeof(void*)) == (char*)c->base + c->offset) {
+        size_t new_off = (size_t)((char*)ptr - (char*)c->base) + VMEM_ALIGN_UP(size, sizeof(void*));
+        if (new_off <= c->reserved && vmem_chunk_ensure_committed(c, new_off)) {
+            c->offset = new_off;
+            return ptr;
+        }
+    }
+    return arena_realloc(a, ptr, old_size, size);
+}
+
+static void omni_scratch_free(void* ctx, void* ptr) {
+    (void)ctx;
+    (void)ptr;  /* reclaimed by the rewind in omni_yyjson_doc_release */
+}
+
+static const yyjson_alc* omni_scratch_alc(void) {
+    static _Thread_local yyjson_alc alc;
+    if (omni_json_scratch_doc) return NULL;  /* already in use: fall back to malloc */
+    alc.malloc = omni_scratch_malloc;
+    alc.realloc = omni_scratch_realloc;
+    alc.free = omni_scratch_free;
+    alc.ctx = &omni_json_arena;
+    return &alc;
+}
+
+static yyjson_doc* omni_scratch_claim(yyjson_doc* doc, const yyjson_alc* alc) {
+    if (doc && alc) omni_json_scratch_doc = doc;
+    return doc;
+}
+
+static void omni_scratch_rewind(void) {
+    Arena* a = &omni_json_arena;
+    size_t committed = 0;
+    for (VMemChunk* c = a->begin; c; c = c->next) committed += c->committed;
+    if (committed > OMNI_JSON_SCRATCH_KEEP) {
+        arena_free(a);  /* one huge document: do not keep its pages forever */
+        return;
+    }
+    for (VMemChunk* c = a->begin; c; c = c->next) c->offset = 0;
+    a->end = a->begin;
+}
+
+/* Parse into the scratch arena; release with omni_yyjson_doc_release */
+yyjson_doc* omni_yyjson_read_scratch(const char* dat, size_t len) {
+    const yyjson_alc* alc = omni_scratch_alc();
+    return omni_scratch_claim(yyjson_read_opts((char*)dat, len, 0, alc, NULL), alc);
+}
+
+/* Free any doc: scratch docs rewind the arena, others go back to malloc */
+void omni_yyjson_doc_release(yyjson_doc* doc) {
+    if (!doc) return;
+    if (doc == omni_json_scratch_doc) {
+        omni_json_scratch_doc = NULL;
+        omni_scratch_rewind();
+        return;
+    }
+    yyjson_doc_free(doc);
+}
+
 /* Wrapper functions for yyjson inline accessors (C3 can't call inline fns) */
 
 yyjson_doc* omni_yyjson_read(const char* dat, size_t len) {
     return yyjson_read(dat, len, 0);
 }
 
+/*
+ * Parse the first JSON value in dat[0..len) and stop (NDJSON / concatenated
+ * JSON). *consumed is how many bytes the value used, including leading
+ * whitespace. On failure *incomplete is 1 if the record was cut off and 2
+ * if the buffer held only whitespace; 0 means the input is invalid.
+ * The doc is a scratch doc: release it with omni_yyjson_doc_release.
+ */
+yyjson_doc* omni_yyjson_read_one(const char* dat, size_t len, size_t* consumed, int* incomplete) {
+    yyjson_read_err err;
+    const yyjson_alc* alc = omni_scratch_alc();
+    yyjson_doc* doc = omni_scratch_claim(
+        yyjson_read_opts((char*)dat, len, YYJSON_READ_STOP_WHEN_DONE, alc, &err), alc);
+    *incomplete = 0;
+    if (!doc) {
+        *consumed = 0;
+        if (err.code == YYJSON_READ_ERROR_UNEXPECTED_END) *incomplete = 1;
+        else if (err.code == YYJSON_READ_ERROR_EMPTY_CONTENT) *incomplete = 2;
+        return NULL;
+    }
+    *consumed = yyjson_doc_get_read_size(doc);
+    return doc;
+}
+
 void omni_yyjson_doc_free(yyjson_doc* doc) {
     yyjson_doc_free(doc);
 }
@@ -47,10 +154,10 @@ size_t omni_yyjson_obj_size(yyjson_val* obj) { return yyjson_obj_size(obj); }
 
 /* Unsafe next (works for both array elements and obj key-val pairs) */
 yyjson_val* omni_yyjson_next(yyjson_val* val) {
-    /* yyjson stores values contiguously. For arrays, next element is val+1.
-       For objects, keys and values alternate: key0 val0 key1 val1...
-       This function advances by 1 slot. */
-    return (yyjson_val*)((char*)val + sizeof(yyjson_val));
+    /* yyjson stores values contiguously in document order: key0 val0 key1 val1...
+       A container's children follow it, so the next sibling of an array or
+       object is past its whole subtree, not at val+1. */
+    return unsafe_yyjson_get_next(val);
 }
 
 /* Object: get first key (keys and values alternate) */
@@ -61,35 +168,19 @@ yyjson_val* omni_yyjson_obj_get_first(yyjson_val* obj) {
     return (yyjson_val*)((char*)obj + sizeof(yyjson_val));
 }
 
-/* =================== Mutable API for json-emit =================== */
-
-yyjson_mut_doc* omni_yyjson_mut_doc_new(void) {
-    return yyjson_mut_doc_new(NULL);
-}
+/* =================== Lookup API for json-doc =================== */
 
-void omni_yyjson_mut_doc_free(yyjson_mut_doc* doc) {
-    yyjson_mut_doc_free(doc);
+/* Object member by key (NULL if missing or obj is not an object) */
+yyjson_val* omni_yyjson_obj_getn(yyjson_val* obj, const char* key, size_t len) {
+    return yyjson_obj_getn(obj, key, len);
 }
 
-yyjson_mut_val* omni_yyjson_mut_null(yyjson_mut_doc* doc) { return yyjson_mut_null(doc); }
-yyjson_mut_val* omni_yyjson_mut_bool(yyjson_mut_doc* doc, int val) { return yyjson_mut_bool(doc, val); }
-yyjson_mut_val* omni_yyjson_mut_sint(yyjson_mut_doc* doc, long long val) { return yyjson_mut_sint(doc, val); }
-yyjson_mut_val* omni_yyjson_mut_real(yyjson_mut_doc* doc, double val) { return yyjson_mut_real(doc, val); }
-yyjson_mut_val* omni_yyjson_mut_strn(yyjson_mut_doc* doc, const char* str, size_t len) { return yyjson_mut_strncpy(doc, str, len); }
-
-yyjson_mut_val* omni_yyjson_mut_arr(yyjson_mut_doc* doc) { return yyjson_mut_arr(doc); }
-void omni_yyjson_mut_arr_append(yyjson_mut_val* arr, yyjson_mut_val* val) { yyjson_mut_arr_append(arr, val); }
-
-yyjson_mut_val* omni_yyjson_mut_obj(yyjson_mut_doc* doc) { return yyjson_mut_obj(doc); }
-void omni_yyjson_mut_obj_add(yyjson_mut_val* obj, yyjson_mut_val* key, yyjson_mut_val* val) { yyjson_mut_obj_add(obj, key, val); }
-
-void omni_yyjson_mut_doc_set_root(yyjson_mut_doc* doc, yyjson_mut_val* root) { yyjson_mut_doc_set_root(doc, root); }
-
-/* Write to string. Returns malloc'd string, caller must free. */
-char* omni_yyjson_mut_write(yyjson_mut_doc* doc, size_t* len) {
-    return yyjson_mut_write(doc, 0, len);
+/* Array element by index (NULL if out of range or arr is not an array) */
+yyjson_val* omni_yyjson_arr_get(yyjson_val* arr, size_t idx) {
+    return yyjson_arr_get(arr, idx);
 }
 
-char* omni_yyjson_mut_write_pretty(yyjson_mut_doc* doc, size_t* len) {
-    return yyjson_mut_write(doc, YYJSON_WRITE_PRETTY, len);
+/* RFC 6901 JSON Pointer ("/a/b/3") from the document root */
+yyjson_val* omni_yyjson_doc_ptr_getn(yyjson_doc* doc, const char* ptr, size_t len) {
+    return yyjson_doc_ptr_getn(doc, ptr, len);
 }
@@ -0,0 +1,101 @@
+/*
+ * net_helpers.c — Non-blocking socket and fd helpers for src/lisp/async.c3
+ * and src/lisp/json.c3. Wraps the calls whose outcome depends on errno
+ * (EINTR retry, EAGAIN, EINPROGRESS), since C3 code here has no errno access.
+ */
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <poll.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+
+/* Return codes shared with src/lisp/async.c3 */
+#define OMNI_NET_ERROR       (-1)
+#define OMNI_NET_WOULD_BLOCK (-2)
+
+/* Put a socket in O_NONBLOCK mode */
+int omni_sock_set_nonblocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    if (flags < 0) return -1;
+    if (flags & O_NONBLOCK) return 0;
+    return fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+}
+
+/* Start a connect on a non-blocking socket. 0 = connected, 1 = in progress, -1 = error. */
+int omni_net_connect_start(int fd, const void *addr, unsigned addrlen) {
+    for (;;) {
+        if (connect(fd, (const struct sockaddr *)addr, (socklen_t)addrlen) == 0) return 0;
+        if (errno == EINTR) continue;
+        if (errno == EINPROGRESS) return 1;
+        return OMNI_NET_ERROR;
+    }
+}
+
+/* Result of an in-progress connect once the fd is writable. 0 = connected. */
+int omni_net_connect_finish(int fd) {
+    int err = 0;
+    socklen_t len = sizeof(err);
+    if (getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &len) < 0) return OMNI_NET_ERROR;
+    return err == 0 ? 0 : OMNI_NET_ERROR;
+}
+
+/* recv: >=0 bytes (0 = EOF), or an OMNI_NET_* status */
+long omni_net_recv(int fd, void *buf, size_t len) {
+    for (;;) {
+        ssize_t r = recv(fd, buf, len, 0);
+        if (r >= 0) return (long)r;
+        if (errno == EINTR) continue;
+        if (errno == EAGAIN || errno == EWOULDBLOCK) return OMNI_NET_WOULD_BLOCK;
+        return OMNI_NET_ERROR;
+    }
+}
+
+/* send: >=0 bytes accepted, or an OMNI_NET_* status */
+long omni_net_send(int fd, const void *buf, size_t len) {
+    for (;;) {
+        ssize_t r = send(fd, buf, len, MSG_NOSIGNAL);
+        if (r >= 0) return (long)r;
+        if (errno == EINTR) continue;
+        if (errno == EAGAIN || errno == EWOULDBLOCK) return OMNI_NET_WOULD_BLOCK;
+        return OMNI_NET_ERROR;
+    }
+}
+
+/* read: >=0 bytes (0 = EOF), or an OMNI_NET_* status */
+long omni_fd_read(int fd, void *buf, size_t len) {
+    for (;;) {
+        ssize_t r = read(fd, buf, len);
+        if (r >= 0) return (long)r;
+        if (errno == EINTR) continue;
+        if (errno == EAGAIN || errno == EWOULDBLOCK) return OMNI_NET_WOULD_BLOCK;
+        return OMNI_NET_ERROR;
+    }
+}
+
+/* 1 if fd can wait for readiness on the I/O loop (pipe, socket, tty).
+ * Regular files are always readable and epoll rejects them. */
+int omni_fd_pollable(int fd) {
+    struct stat st;
+    if (fstat(fd, &st) != 0) return 0;
+    return S_ISFIFO(st.st_mode) || S_ISSOCK(st.st_mode) || S_ISCHR(st.st_mode);
+}
+
+/* Block in poll(2) until fd is readable (want_write = 0) or writable.
+ * Retries only on EINTR. 0 = ready, including error and hangup states, which
+ * the caller's next recv/send reports; OMNI_NET_ERROR if poll itself fails. */
+int omni_net_wait_fd(int fd, int want_write) {
+    if (fd < 0) return OMNI_NET_ERROR;
+    struct pollfd p;
+    p.fd = fd;
+    p.events = want_write ? POLLOUT : POLLIN;
+    p.revents = 0;
+    for (;;) {
+        int r = poll(&p, 1, -1);
+        if (r > 0) return 0;
+        if (r < 0 && errno == EINTR) continue;
+        return OMNI_NET_ERROR;
+    }
+}
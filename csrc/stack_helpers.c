@@ -4,6 +4,7 @@
  * Provides:
  *   D1: FPU state save/restore (stmxcsr/ldmxcsr/fnstcw/fldcw)
  *   D2: Stack overflow detection via SIGSEGV + sigaltstack
+ *   Copy-on-write sharing of suspended stacks between continuation clones
  *
  * Called from C3 via extern declarations in stack_engine.c3.
  */
@@ -93,14 +94,42 @@ void stack_asan_finish_switch(void* fake_stack_save) {
 }
 
 /* Raw stack copy for continuation clone.
- * ASAN redzones exist inside suspended stacks; cloning must copy raw bytes.
+ * ASAN redzones exist inside suspended stacks; cloning must copy raw bytes,
+ * so this cannot go through (intercepted) memcpy. 64 bytes per iteration
+ * with unaligned SSE2 moves, then 8-byte words, then a byte tail. Loop
+ * idiom recognition is disabled on GCC so the loop is not turned back
+ * into a memcpy call.
  */
-OMNI_NO_ASAN
+#include <emmintrin.h>
+
+#if defined(__GNUC__) && !defined(__clang__)
+#  define OMNI_NO_MEMCPY_IDIOM __attribute__((optimize("no-tree-loop-distribute-patterns")))
+#else
+#  define OMNI_NO_MEMCPY_IDIOM
+#endif
+
+OMNI_NO_ASAN OMNI_NO_MEMCPY_IDIOM
 void stack_raw_copy(void* dst, const void* src, size_t size) {
     unsigned char* d = (unsigned char*)dst;
     const unsigned char* s = (const unsigned char*)src;
-    for (size_t i = 0; i < size; i++) {
-        d[i] = s[i];
+    while (size >= 64) {
+        __m128i a = _mm_loadu_si128((const __m128i*)(s + 0));
+        __m128i b = _mm_loadu_si128((const __m128i*)(s + 16));
+        __m128i c = _mm_loadu_si128((const __m128i*)(s + 32));
+        __m128i e = _mm_loadu_si128((const __m128i*)(s + 48));
+        _mm_storeu_si128((__m128i*)(d + 0), a);
+        _mm_storeu_si128((__m128i*)(d + 16), b);
+        _mm_storeu_si128((__m128i*)(d + 32), c);
+        _mm_storeu_si128((__m128i*)(d + 48), e);
+        d += 64; s += 64; size -= 64;
+    }
+    while (size >= 8) {
+        _mm_storel_epi64((__m128i*)d, _mm_loadl_epi64((const __m128i*)s));
+        d += 8; s += 8; size -= 8;
+    }
+    while (size > 0) {
+        *d++ = *s++;
+        size--;
     }
 }
 
@@ -113,52 +142,215 @@ void stack_raw_copy(void* dst, const void* src, size_t size) {
  * if the fault address is in a known guard page. If so, it
  * siglongjmps to the recovery point set before the context switch.
  *
- * Recovery points form a stack to support nested coro switches.
+ * Guard pages live in an open-addressed hash set keyed by guard base
+ * address, so lookup is O(1) and there is no registration cap. The
+ * handler only performs atomic loads: writers (serialized by a mutex)
+ * fill a slot's size before publishing its base, and a grown table is
+ * built completely before it is swapped in. A replaced table goes on a
+ * retired list, since a handler on another thread may still be probing
+ * it; retired tables are freed at the next quiescent point, when no
+ * handler is running (g_handlers_active is zero after the swap).
+ *
+ * Reserved fiber stacks are mapped read/write with MAP_NORESERVE, so the
+ * kernel backs their pages on first touch, including touches made on
+ * the stack's behalf by a syscall. stack_guard_decommit hands deep pages
+ * back to the OS when a stack is recycled, and stack_guard_resident
+ * reports how much of a stack is backed.
+ *
+ * Recovery points are a per-thread linked list of frames that live in
+ * stack_guard_protected_switch's own C frame, so nesting depth is
+ * unbounded and every OS thread recovers independently. Each thread
+ * that runs coroutines needs its own sigaltstack: stack_guard_init
+ * covers the calling thread, other threads call stack_guard_thread_init.
  */
 
-#define MAX_GUARD_PAGES 256
-#define MAX_RECOVERY_DEPTH 64
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#define GUARD_EMPTY     ((uintptr_t)0)
+#define GUARD_TOMBSTONE ((uintptr_t)1)
+#define GUARD_MIN_CAP   64
+#define GUARD_MAX_PAGES 512  /* largest stack mapping (2MB) the handler probes for */
 
-struct guard_entry {
-    void*  base;
-    size_t size;
+struct cow_link;
+
+struct guard_slot {
+    _Atomic uintptr_t base;  /* GUARD_EMPTY, GUARD_TOMBSTONE, or page-aligned base */
+    _Atomic size_t    size;  /* guard extent */
+    _Atomic size_t    span;  /* whole stack mapping (>= size; see stack_guard_set_span) */
+    struct cow_link* _Atomic cow_src;  /* COW clones reading from this stack */
+    struct cow_link* _Atomic cow_dst;  /* COW link this stack is the clone side of */
+};
+
+struct guard_table {
+    size_t cap;              /* power of two */
+    size_t live;
+    size_t used;             /* live + tombstones */
+    struct guard_table* retired_next;
+    struct guard_slot slots[];
+};
+
+struct recovery_frame {
+    sigjmp_buf env;
+    struct recovery_frame* prev;
 };
 
-static struct guard_entry g_guards[MAX_GUARD_PAGES];
-static int g_guard_count = 0;
+static struct guard_table* _Atomic g_guards = NULL;
+static struct guard_table* g_guards_retired = NULL;
+static _Atomic unsigned g_handlers_active = 0;  /* SIGSEGV handlers between lookup and exit */
+static pthread_mutex_t g_guard_lock = PTHREAD_MUTEX_INITIALIZER;
+static uintptr_t g_page_size = 4096;
 
-static sigjmp_buf g_recovery_stack[MAX_RECOVERY_DEPTH];
-static int g_recovery_depth = 0;
-static volatile sig_atomic_t g_guard_hit = 0;
+static _Thread_local struct recovery_frame* g_recovery_top = NULL;
+static _Thread_local volatile sig_atomic_t g_guard_hit = 0;
+static _Thread_local void* g_sigstack = NULL;
 
-static void* g_sigstack = NULL;
 static int g_initialized = 0;
 
 /* The context switch function defined in stack_engine.c3 (@naked, SysV ABI) */
 extern void omni_context_switch(void* old_ctx, void* new_ctx);
 
-static void sigsegv_handler(int sig, siginfo_t* info, void* ucontext) {
-    (void)sig; (void)ucontext;
+static inline size_t guard_hash(uintptr_t base, size_t cap) {
+    /* Bases are page aligned; drop the zero bits and mix (Fibonacci hashing). */
+    uint64_t h = (uint64_t)(base / g_page_size) * 0x9E3779B97F4A7C15ull;
+    return (size_t)(h >> 32) & (cap - 1);
+}
+
+/* Async-signal-safe: atomic loads only. Returns the slot for base, or NULL. */
+static struct guard_slot* guard_lookup_in(struct guard_table* t, uintptr_t base) {
+    if (t == NULL) return NULL;
+    size_t mask = t->cap - 1;
+    for (size_t i = guard_hash(base, t->cap), n = 0; n < t->cap; i = (i + 1) & mask, n++) {
+        uintptr_t b = __atomic_load_n(&t->slots[i].base, __ATOMIC_ACQUIRE);
+        if (b == GUARD_EMPTY) return NULL;
+        if (b == base) return &t->slots[i];
+    }
+    return NULL;
+}
 
-    if (g_recovery_depth <= 0)
-        goto reraise;
+static struct guard_slot* guard_lookup(uintptr_t base) {
+    return guard_lookup_in(__atomic_load_n(&g_guards, __ATOMIC_SEQ_CST), base);
+}
 
-    {
-        uintptr_t addr = (uintptr_t)info->si_addr;
-        for (int i = 0; i < g_guard_count; i++) {
-            uintptr_t lo = (uintptr_t)g_guards[i].base;
-            uintptr_t hi = lo + g_guards[i].size;
-            if (addr >= lo && addr < hi) {
-                g_guard_hit = 1;
-                int depth = g_recovery_depth - 1;
-                g_recovery_depth = depth;
-                siglongjmp(g_recovery_stack[depth], 1);
-                /* NOTREACHED */
+/* Find the registered stack whose mapping contains addr; base goes to *base_out. */
+static struct guard_slot* guard_find(uintptr_t addr, uintptr_t* base_out) {
+    uintptr_t page = addr & ~(g_page_size - 1);
+    for (uintptr_t k = 0; k < GUARD_MAX_PAGES && page >= k * g_page_size; k++) {
+        uintptr_t base = page - k * g_page_size;
+        struct guard_slot* g = guard_lookup(base);
+        if (g != NULL) {
+            /* Regions never overlap, so the nearest base below decides. */
+            size_t size = __atomic_load_n(&g->size, __ATOMIC_ACQUIRE);
+            size_t span = __atomic_load_n(&g->span, __ATOMIC_RELAXED);
+            if (addr >= base + (span > size ? span : size)) return NULL;
+            *base_out = base;
+            return g;
+        }
+    }
+    return NULL;
+}
+
+static int cow_fault(struct guard_slot* g, uintptr_t addr);
+static void cow_release_locked(struct guard_slot* g);
+
+/* Writers below hold g_guard_lock. */
+static void guard_insert_slot(struct guard_table* t, uintptr_t base, size_t size) {
+    size_t mask = t->cap - 1;
+    size_t i = guard_hash(base, t->cap);
+    while (1) {
+        uintptr_t b = __atomic_load_n(&t->slots[i].base, __ATOMIC_RELAXED);
+        if (b == GUARD_EMPTY || b == GUARD_TOMBSTONE) {
+            if (b == GUARD_EMPTY) t->used++;
+            __atomic_store_n(&t->slots[i].size, size, __ATOMIC_RELAXED);
+            __atomic_store_n(&t->slots[i].span, size, __ATOMIC_RELAXED);
+            __atomic_store_n(&t->slots[i].cow_src, NULL, __ATOMIC_RELAXED);
+            __atomic_store_n(&t->slots[i].cow_dst, NULL, __ATOMIC_RELAXED);
+            __atomic_store_n(&t->slots[i].base, base, __ATOMIC_RELEASE);
+            t->live++;
+            return;
+        }
+        i = (i + 1) & mask;
+    }
+}
+
+static struct guard_table* guard_table_new(size_t cap) {
+    struct guard_table* t = calloc(1, sizeof(*t) + cap * sizeof(struct guard_slot));
+    if (t) t->cap = cap;
+    return t;
+}
+
+/*
+ * Free retired tables if no handler can still hold one. A handler counts
+ * itself in before it loads g_guards, and every retired table was
+ * replaced before this load (both seq_cst), so with no handler active
+ * none can reach a retired table again.
+ */
+static void guard_reclaim_locked(void) {
+    if (g_guards_retired == NULL) return;
+    if (__atomic_load_n(&g_handlers_active, __ATOMIC_SEQ_CST) != 0) return;
+    while (g_guards_retired) {
+        struct guard_table* next = g_guards_retired->retired_next;
+        free(g_guards_retired);
+        g_guards_retired = next;
+    }
+}
+
+/* Ensure room for one more entry (load factor <= 1/2 counting tombstones). */
+static struct guard_table* guard_reserve(void) {
+    struct guard_table* t = __atomic_load_n(&g_guards, __ATOMIC_RELAXED);
+    if (t && (t->used + 1) * 2 <= t->cap) return t;
+
+    size_t cap = GUARD_MIN_CAP;
+    while (t && cap < (t->live + 1) * 4) cap <<= 1;
+    struct guard_table* nt = guard_table_new(cap);
+    if (!nt) return NULL;
+    if (t) {
+        for (size_t i = 0; i < t->cap; i++) {
+            uintptr_t b = __atomic_load_n(&t->slots[i].base, __ATOMIC_RELAXED);
+            if (b > GUARD_TOMBSTONE) {
+                struct guard_slot* o = &t->slots[i];
+                guard_insert_slot(nt, b, __atomic_load_n(&o->size, __ATOMIC_RELAXED));
+                struct guard_slot* n = guard_lookup_in(nt, b);
+                __atomic_store_n(&n->span, __atomic_load_n(&o->span, __ATOMIC_RELAXED), __ATOMIC_RELAXED);
+                __atomic_store_n(&n->cow_src, __atomic_load_n(&o->cow_src, __ATOMIC_RELAXED), __ATOMIC_RELAXED);
+                __atomic_store_n(&n->cow_dst, __atomic_load_n(&o->cow_dst, __ATOMIC_RELAXED), __ATOMIC_RELAXED);
             }
         }
+        t->retired_next = g_guards_retired;
+        g_guards_retired = t;
+    }
+    __atomic_store_n(&g_guards, nt, __ATOMIC_SEQ_CST);
+    guard_reclaim_locked();
+    return nt;
+}
+
+static void sigsegv_handler(int sig, siginfo_t* info, void* ucontext) {
+    (void)sig; (void)ucontext;
+
+    uintptr_t addr = (uintptr_t)info->si_addr;
+    uintptr_t base = 0;
+    __atomic_add_fetch(&g_handlers_active, 1, __ATOMIC_SEQ_CST);
+    struct guard_slot* g = guard_find(addr, &base);
+
+    /* Committed stack above the guard: a copy-on-write clone page. */
+    if (g != NULL && addr >= base + __atomic_load_n(&g->size, __ATOMIC_ACQUIRE)) {
+        int handled = cow_fault(g, addr);
+        __atomic_sub_fetch(&g_handlers_active, 1, __ATOMIC_SEQ_CST);
+        if (handled) return;
+        g = NULL;
+    } else {
+        __atomic_sub_fetch(&g_handlers_active, 1, __ATOMIC_SEQ_CST);
+    }
+
+    struct recovery_frame* top = g_recovery_top;
+    if (top != NULL && g != NULL) {
+        g_guard_hit = 1;
+        g_recovery_top = top->prev;
+        siglongjmp(top->env, 1);
+        /* NOTREACHED */
     }
 
-reraise:
     /* Not a known guard page — restore default handler and re-raise */
     {
         struct sigaction sa;
@@ -169,10 +361,10 @@ reraise:
     }
 }
 
-int stack_guard_init(void) {
-    if (g_initialized) return 0;
+/* Install the alternate signal stack for the calling thread. */
+int stack_guard_thread_init(void) {
+    if (g_sigstack) return 0;
 
-    /* Allocate alternate signal stack */
     g_sigstack = malloc(SIGSTKSZ);
     if (!g_sigstack) return -1;
 
@@ -185,6 +377,28 @@ int stack_guard_init(void) {
         free(g_sigstack); g_sigstack = NULL;
         return -1;
     }
+    return 0;
+}
+
+void stack_guard_thread_shutdown(void) {
+    if (!g_sigstack) return;
+
+    stack_t ss;
+    memset(&ss, 0, sizeof(ss));
+    ss.ss_flags = SS_DISABLE;
+    sigaltstack(&ss, NULL);
+
+    free(g_sigstack); g_sigstack = NULL;
+    g_recovery_top = NULL;
+}
+
+int stack_guard_init(void) {
+    if (g_initialized) return stack_guard_thread_init();
+
+    long ps = sysconf(_SC_PAGESIZE);
+    if (ps > 0) g_page_size = (uintptr_t)ps;
+
+    if (stack_guard_thread_init() < 0) return -1;
 
     /* Install SIGSEGV handler on alternate stack */
     struct sigaction sa;
@@ -193,7 +407,7 @@ int stack_guard_init(void) {
     sigemptyset(&sa.sa_mask);
     sa.sa_flags = SA_SIGINFO | SA_ONSTACK;
     if (sigaction(SIGSEGV, &sa, NULL) < 0) {
-        free(g_sigstack); g_sigstack = NULL;
+        stack_guard_thread_shutdown();
         return -1;
     }
 
@@ -209,59 +423,342 @@ void stack_guard_shutdown(void) {
     sa.sa_handler = SIG_DFL;
     sigaction(SIGSEGV, &sa, NULL);
 
-    stack_t ss;
-    memset(&ss, 0, sizeof(ss));
-    ss.ss_flags = SS_DISABLE;
-    sigaltstack(&ss, NULL);
+    stack_guard_thread_shutdown();
 
-    free(g_sigstack); g_sigstack = NULL;
-    g_guard_count = 0;
-    g_recovery_depth = 0;
+    pthread_mutex_lock(&g_guard_lock);
+    free(__atomic_exchange_n(&g_guards, NULL, __ATOMIC_ACQ_REL));
+    while (g_guards_retired) {
+        struct guard_table* next = g_guards_retired->retired_next;
+        free(g_guards_retired);
+        g_guards_retired = next;
+    }
+    pthread_mutex_unlock(&g_guard_lock);
     g_initialized = 0;
 }
 
 void stack_guard_register(void* base, size_t size) {
-    if (g_guard_count < MAX_GUARD_PAGES) {
-        g_guards[g_guard_count].base = base;
-        g_guards[g_guard_count].size = size;
-        g_guard_count++;
+    if (base == NULL || size == 0) return;
+    pthread_mutex_lock(&g_guard_lock);
+    struct guard_table* t = guard_reserve();
+    if (t) guard_insert_slot(t, (uintptr_t)base, size);
+    pthread_mutex_unlock(&g_guard_lock);
+}
+
+/*
+ * Return the pages of a stack between its guard and keep_lo to the OS.
+ * They stay mapped read/write and read back as zero on next touch.
+ * Only for stacks that are not running.
+ */
+void stack_guard_decommit(void* base, void* keep_lo) {
+    pthread_mutex_lock(&g_guard_lock);
+    struct guard_slot* g = guard_lookup((uintptr_t)base);
+    if (g != NULL) {
+        cow_release_locked(g);
+        uintptr_t lo = (uintptr_t)base + __atomic_load_n(&g->size, __ATOMIC_RELAXED);
+        uintptr_t keep = (uintptr_t)keep_lo & ~(g_page_size - 1);
+        if (keep > lo) madvise((void*)lo, keep - lo, MADV_DONTNEED);
+    }
+    pthread_mutex_unlock(&g_guard_lock);
+}
+
+/* Bytes of [lo, lo+len) backed by memory (lo page aligned). */
+size_t stack_guard_resident(void* lo, size_t len) {
+    unsigned char vec[256];
+    size_t pages = (len + g_page_size - 1) / g_page_size;
+    size_t n = 0;
+    for (size_t done = 0; done < pages; ) {
+        size_t chunk = pages - done < sizeof(vec) ? pages - done : sizeof(vec);
+        if (mincore((char*)lo + done * g_page_size, chunk * g_page_size, vec) != 0) return 0;
+        for (size_t i = 0; i < chunk; i++) n += vec[i] & 1;
+        done += chunk;
+    }
+    return n * g_page_size;
+}
+
+/*
+ * Record the full extent of a registered stack mapping, so faults in its
+ * committed part can be matched to it (see the copy-on-write clones below).
+ */
+void stack_guard_set_span(void* base, size_t span) {
+    pthread_mutex_lock(&g_guard_lock);
+    struct guard_slot* g = guard_lookup((uintptr_t)base);
+    if (g != NULL && span >= __atomic_load_n(&g->size, __ATOMIC_RELAXED)) {
+        __atomic_store_n(&g->span, span, __ATOMIC_RELEASE);
     }
+    pthread_mutex_unlock(&g_guard_lock);
 }
 
 void stack_guard_unregister(void* base) {
-    for (int i = 0; i < g_guard_count; i++) {
-        if (g_guards[i].base == base) {
-            g_guards[i] = g_guards[g_guard_count - 1];
-            g_guard_count--;
-            return;
+    pthread_mutex_lock(&g_guard_lock);
+    struct guard_slot* g = guard_lookup((uintptr_t)base);
+    if (g != NULL) cow_release_locked(g);
+    struct guard_table* t = __atomic_load_n(&g_guards, __ATOMIC_RELAXED);
+    if (t) {
+        size_t mask = t->cap - 1;
+        for (size_t i = guard_hash((uintptr_t)base, t->cap), n = 0; n < t->cap; i = (i + 1) & mask, n++) {
+            uintptr_t b = __atomic_load_n(&t->slots[i].base, __ATOMIC_RELAXED);
+            if (b == GUARD_EMPTY) break;
+            if (b == (uintptr_t)base) {
+                __atomic_store_n(&t->slots[i].base, GUARD_TOMBSTONE, __ATOMIC_RELEASE);
+                t->live--;
+                break;
+            }
         }
     }
+    guard_reclaim_locked();
+    pthread_mutex_unlock(&g_guard_lock);
+}
+
+/* Replaced guard tables not yet freed (diagnostics/tests). */
+size_t stack_guard_retired(void) {
+    pthread_mutex_lock(&g_guard_lock);
+    size_t n = 0;
+    for (struct guard_table* t = g_guards_retired; t != NULL; t = t->retired_next) n++;
+    pthread_mutex_unlock(&g_guard_lock);
+    return n;
+}
+
+/* Number of registered guard regions (diagnostics/tests). */
+size_t stack_guard_count(void) {
+    pthread_mutex_lock(&g_guard_lock);
+    struct guard_table* t = __atomic_load_n(&g_guards, __ATOMIC_RELAXED);
+    size_t n = t ? t->live : 0;
+    pthread_mutex_unlock(&g_guard_lock);
+    return n;
 }
 
 /**
  * Protected context switch with stack overflow recovery.
  *
  * Wraps sigsetjmp + context switch so the sigsetjmp frame is live
- * when siglongjmp fires from the SIGSEGV handler.
+ * when siglongjmp fires from the SIGSEGV handler. The recovery frame
+ * is pushed on this thread's list for the duration of the switch.
  *
  * Returns 0 on normal switch-back, 1 on stack overflow recovery.
  */
 int stack_guard_protected_switch(void* old_ctx, void* new_ctx) {
-    if (g_recovery_depth >= MAX_RECOVERY_DEPTH) {
-        /* Too deep — switch without protection */
-        omni_context_switch(old_ctx, new_ctx);
-        return 0;
-    }
+    struct recovery_frame frame;
 
     g_guard_hit = 0;
-    if (sigsetjmp(g_recovery_stack[g_recovery_depth], 1) != 0) {
-        /* Stack overflow — siglongjmp'd back here */
+    frame.prev = g_recovery_top;
+    if (sigsetjmp(frame.env, 1) != 0) {
+        /* Stack overflow — siglongjmp'd back here (handler already popped) */
         return 1;
     }
-    g_recovery_depth++;
+    g_recovery_top = &frame;
 
     omni_context_switch(old_ctx, new_ctx);
 
-    g_recovery_depth--;
+    g_recovery_top = frame.prev;
+    return 0;
+}
+
+/* ============================================================
+ * Copy-on-write continuation clones
+ * ============================================================
+ *
+ * stack_cow_clone links the active segment of a suspended stack to a
+ * clone's stack instead of copying it. The source pages turn read-only
+ * and the clone's pages PROT_NONE; the SIGSEGV handler copies a page
+ * into the clone the first time the clone touches it, or just before
+ * the source writes it, and then lifts the protection on that page.
+ * A source may feed several clones; a clone has at most one source.
+ *
+ * Links hang off guard slots, so both stacks must be registered and have
+ * their span set. The handler updates link bitmaps without the lock, so
+ * every stack taking part in a link must run on the same OS thread.
+ * Unregistering or decommitting a stack dissolves its links: clones of
+ * it receive their remaining pages, and its own pending pages are dropped.
+ *
+ * The kernel does not fault on behalf of a syscall: a syscall writing
+ * into a still-shared source page, or reading an untouched clone page,
+ * fails with EFAULT. That is why the pool only uses this when asked to.
+ */
+
+struct cow_link {
+    uintptr_t src_lo;           /* first shared page in the source */
+    uintptr_t dst_lo;           /* matching page in the clone */
+    size_t    pages;
+    uintptr_t src_base;         /* guard bases, to find the slots again */
+    uintptr_t dst_base;
+    struct cow_link* _Atomic next_src;  /* next clone of the same source */
+    unsigned char pending[];    /* bit i: page i not yet copied to the clone */
+};
+
+static inline int cow_pending(const struct cow_link* l, size_t i) {
+    return (l->pending[i >> 3] >> (i & 7)) & 1;
+}
+
+static inline int cow_covers(const struct cow_link* l, uintptr_t lo, uintptr_t page) {
+    return page >= lo && page < lo + l->pages * g_page_size;
+}
+
+static void cow_materialize(struct cow_link* l, size_t i) {
+    uintptr_t d = l->dst_lo + i * g_page_size;
+    mprotect((void*)d, g_page_size, PROT_READ | PROT_WRITE);
+    stack_raw_copy((void*)d, (const void*)(l->src_lo + i * g_page_size), g_page_size);
+    l->pending[i >> 3] &= (unsigned char)~(1u << (i & 7));
+}
+
+/* Is this source page still owed to some clone? */
+static int cow_src_shared(struct guard_slot* src, uintptr_t page) {
+    for (struct cow_link* l = __atomic_load_n(&src->cow_src, __ATOMIC_ACQUIRE); l; l = l->next_src) {
+        if (cow_covers(l, l->src_lo, page) && cow_pending(l, (page - l->src_lo) / g_page_size)) return 1;
+    }
     return 0;
 }
+
+/* Handler side: resolve a fault on a linked page. 1 = handled, retry. */
+static int cow_fault(struct guard_slot* g, uintptr_t addr) {
+    uintptr_t page = addr & ~(g_page_size - 1);
+
+    struct cow_link* l = __atomic_load_n(&g->cow_dst, __ATOMIC_ACQUIRE);
+    if (l != NULL && cow_covers(l, l->dst_lo, page)) {
+        size_t i = (page - l->dst_lo) / g_page_size;
+        if (cow_pending(l, i)) {
+            cow_materialize(l, i);
+            return 1;
+        }
+    }
+
+    int hit = 0;
+    for (l = __atomic_load_n(&g->cow_src, __ATOMIC_ACQUIRE); l; l = l->next_src) {
+        if (!cow_covers(l, l->src_lo, page)) continue;
+        size_t i = (page - l->src_lo) / g_page_size;
+        if (cow_pending(l, i)) {
+            cow_materialize(l, i);
+            hit = 1;
+        }
+    }
+    if (hit) mprotect((void*)page, g_page_size, PROT_READ | PROT_WRITE);
+    return hit;
+}
+
+/*
+ * Dissolve one link (lock held). materialize != 0 copies the clone's
+ * remaining pages first (the source is going away); otherwise they are
+ * dropped (the clone is going away). Source pages no other clone still
+ * needs become writable again.
+ */
+static void cow_unlink(struct cow_link* l, int materialize) {
+    struct guard_slot* d = guard_lookup(l->dst_base);
+    struct guard_slot* s = guard_lookup(l->src_base);
+    if (d != NULL) __atomic_store_n(&d->cow_dst, NULL, __ATOMIC_RELEASE);
+    if (s != NULL) {
+        struct cow_link* _Atomic* pp = &s->cow_src;
+        struct cow_link* cur;
+        while ((cur = __atomic_load_n(pp, __ATOMIC_RELAXED)) != NULL) {
+            if (cur == l) {
+                __atomic_store_n(pp, l->next_src, __ATOMIC_RELEASE);
+                break;
+            }
+            pp = &cur->next_src;
+        }
+    }
+    for (size_t i = 0; i < l->pages; i++) {
+        if (!cow_pending(l, i)) continue;
+        if (materialize) {
+            cow_materialize(l, i);
+        } else {
+            mprotect((void*)(l->dst_lo + i * g_page_size), g_page_size, PROT_READ | PROT_WRITE);
+        }
+        uintptr_t sp = l->src_lo + i * g_page_size;
+        if (s == NULL || !cow_src_shared(s, sp)) {
+            mprotect((void*)sp, g_page_size, PROT_READ | PROT_WRITE);
+        }
+    }
+    free(l);
+}
+
+static void cow_release_locked(struct guard_slot* g) {
+    struct cow_link* l = __atomic_load_n(&g->cow_dst, __ATOMIC_ACQUIRE);
+    if (l != NULL) cow_unlink(l, 0);
+    while ((l = __atomic_load_n(&g->cow_src, __ATOMIC_ACQUIRE)) != NULL) cow_unlink(l, 1);
+}
+
+/*
+ * Share [src_lo, src_hi) of a suspended stack with a clone whose copy
+ * starts at dst_lo (same offset within its page). The clone must be a
+ * fresh, registered stack with no links of its own. Returns 0 when the
+ * link is in place, -1 when the caller should copy eagerly instead.
+ */
+int stack_cow_clone(void* src_base, void* src_lo, void* src_hi, void* dst_base, void* dst_lo) {
+    uintptr_t off = (uintptr_t)src_lo & (g_page_size - 1);
+    if (((uintptr_t)dst_lo & (g_page_size - 1)) != off) return -1;
+    uintptr_t s = (uintptr_t)src_lo - off;
+    uintptr_t d = (uintptr_t)dst_lo - off;
+    uintptr_t hi = ((uintptr_t)src_hi + g_page_size - 1) & ~(g_page_size - 1);
+    if (hi <= s) return -1;
+    size_t pages = (hi - s) / g_page_size;
+    size_t len = pages * g_page_size;
+
+    pthread_mutex_lock(&g_guard_lock);
+    int rc = -1;
+    struct guard_slot* gs = guard_lookup((uintptr_t)src_base);
+    struct guard_slot* gd = guard_lookup((uintptr_t)dst_base);
+    if (gs == NULL || gd == NULL || gs == gd) goto out;
+    if (__atomic_load_n(&gd->cow_dst, __ATOMIC_RELAXED) != NULL ||
+        __atomic_load_n(&gd->cow_src, __ATOMIC_RELAXED) != NULL) goto out;
+    if (s + len > (uintptr_t)src_base + __atomic_load_n(&gs->span, __ATOMIC_RELAXED) ||
+        d + len > (uintptr_t)dst_base + __atomic_load_n(&gd->span, __ATOMIC_RELAXED)) goto out;
+
+    /* A clone of a clone: bring the source's own pages home first. */
+    struct cow_link* own = __atomic_load_n(&gs->cow_dst, __ATOMIC_RELAXED);
+    if (own != NULL) cow_unlink(own, 1);
+
+    if (d < (uintptr_t)dst_base + __atomic_load_n(&gd->size, __ATOMIC_RELAXED)) goto out;
+
+    size_t bytes = (pages + 7) / 8;
+    struct cow_link* l = malloc(sizeof(*l) + bytes);
+    if (l == NULL) goto out;
+    l->src_lo = s;
+    l->dst_lo = d;
+    l->pages = pages;
+    l->src_base = (uintptr_t)src_base;
+    l->dst_base = (uintptr_t)dst_base;
+    for (size_t i = 0; i < bytes; i++) l->pending[i] = 0xFF;
+    if (pages & 7) l->pending[bytes - 1] = (unsigned char)((1u << (pages & 7)) - 1);
+
+    if (mprotect((void*)s, len, PROT_READ) != 0) {
+        free(l);
+        goto out;
+    }
+    if (mprotect((void*)d, len, PROT_NONE) != 0) {
+        /* Restore whatever the source had before this attempt. */
+        for (size_t i = 0; i < pages; i++) {
+            if (!cow_src_shared(gs, s + i * g_page_size)) {
+                mprotect((void*)(s + i * g_page_size), g_page_size, PROT_READ | PROT_WRITE);
+            }
+        }
+        free(l);
+        goto out;
+    }
+    __atomic_store_n(&l->next_src, __atomic_load_n(&gs->cow_src, __ATOMIC_RELAXED), __ATOMIC_RELAXED);
+    __atomic_store_n(&gs->cow_src, l, __ATOMIC_RELEASE);
+    __atomic_store_n(&gd->cow_dst, l, __ATOMIC_RELEASE);
+    rc = 0;
+out:
+    pthread_mutex_unlock(&g_guard_lock);
+    return rc;
+}
+
+/* Dissolve every link the stack at base takes part in. */
+void stack_cow_release(void* base) {
+    pthread_mutex_lock(&g_guard_lock);
+    struct guard_slot* g = guard_lookup((uintptr_t)base);
+    if (g != NULL) cow_release_locked(g);
+    pthread_mutex_unlock(&g_guard_lock);
+}
+
+/* Pages a clone still shares with its source (diagnostics/tests). */
+size_t stack_cow_pending(void* base) {
+    pthread_mutex_lock(&g_guard_lock);
+    size_t n = 0;
+    struct guard_slot* g = guard_lookup((uintptr_t)base);
+    struct cow_link* l = g ? __atomic_load_n(&g->cow_dst, __ATOMIC_RELAXED) : NULL;
+    if (l != NULL) {
+        for (size_t i = 0; i < l->pages; i++) n += (size_t)cow_pending(l, i);
+    }
+    pthread_mutex_unlock(&g_guard_lock);
+    return n;
+}
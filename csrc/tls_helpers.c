@@ -1,33 +1,140 @@
 /*
  * tls_helpers.c — Minimal BearSSL helpers for Omni Lisp
- * Only needed for: socket I/O callbacks (C3 can't easily match the exact signature)
+ * Drives br_ssl_engine directly over a non-blocking socket so that a
+ * fiber can park on EAGAIN instead of stalling the whole interpreter.
+ * The record pump mirrors br_sslio's run_until loop, minus the blocking I/O.
  */
 
+#include <bearssl.h>
 #include <unistd.h>
 #include <errno.h>
+#include <string.h>
 
-/* Socket read callback for br_sslio_init */
-int omni_tls_sock_read(void *ctx, unsigned char *buf, size_t len) {
-    int fd = *(int *)ctx;
+/* Return codes shared with src/lisp/tls.c3 */
+#define OMNI_TLS_ERROR      (-1)
+#define OMNI_TLS_WANT_READ  (-2)
+#define OMNI_TLS_WANT_WRITE (-3)
+
+/* Push pending outgoing records to the socket. 1 = drained, <0 = status. */
+static int omni_tls_send_records(br_ssl_engine_context *eng, int fd) {
+    size_t len;
+    unsigned char *buf = br_ssl_engine_sendrec_buf(eng, &len);
     for (;;) {
-        long rlen = read(fd, buf, len);
-        if (rlen <= 0) {
-            if (rlen < 0 && errno == EINTR) continue;
-            return -1;
+        ssize_t w = write(fd, buf, len);
+        if (w < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) return OMNI_TLS_WANT_WRITE;
+            br_ssl_engine_fail(eng, BR_ERR_IO);
+            return OMNI_TLS_ERROR;
         }
-        return (int)rlen;
+        br_ssl_engine_sendrec_ack(eng, (size_t)w);
+        return 1;
     }
 }
 
-/* Socket write callback for br_sslio_init */
-int omni_tls_sock_write(void *ctx, const unsigned char *buf, size_t len) {
-    int fd = *(int *)ctx;
+/*
+ * Run the engine until one of the `target` state bits is set.
+ * Returns 1 when reached, 0 on clean close, or an OMNI_TLS_* status.
+ */
+static int omni_tls_run_until(br_ssl_engine_context *eng, int fd, unsigned target) {
     for (;;) {
-        long wlen = write(fd, buf, len);
-        if (wlen <= 0) {
-            if (wlen < 0 && errno == EINTR) continue;
-            return -1;
+        unsigned state = br_ssl_engine_current_state(eng);
+        if (state & BR_SSL_CLOSED) {
+            return br_ssl_engine_last_error(eng) == BR_ERR_OK ? 0 : OMNI_TLS_ERROR;
         }
-        return (int)wlen;
+        if (state & BR_SSL_SENDREC) {
+            int r = omni_tls_send_records(eng, fd);
+            if (r < 0) return r;
+            continue;
+        }
+        if (state & target) return 1;
+        /* Application data is waiting but the caller wants to write: the
+         * peer expects us to read first. */
+        if (state & BR_SSL_RECVAPP) return OMNI_TLS_ERROR;
+        if (state & BR_SSL_RECVREC) {
+            size_t len;
+            unsigned char *buf = br_ssl_engine_recvrec_buf(eng, &len);
+            ssize_t r = read(fd, buf, len);
+            if (r == 0) {
+                br_ssl_engine_fail(eng, BR_ERR_IO);
+                return 0;
+            }
+            if (r < 0) {
+                if (errno == EINTR) continue;
+                if (errno == EAGAIN || errno == EWOULDBLOCK) return OMNI_TLS_WANT_READ;
+                br_ssl_engine_fail(eng, BR_ERR_IO);
+                return OMNI_TLS_ERROR;
+            }
+            br_ssl_engine_recvrec_ack(eng, (size_t)r);
+            continue;
+        }
+        br_ssl_engine_flush(eng, 0);
+    }
+}
+
+/* Read up to len bytes of application data. >0 bytes, 0 = EOF, <0 = status. */
+int omni_tls_engine_read(void *cc, int fd, unsigned char *out, size_t len) {
+    br_ssl_engine_context *eng = (br_ssl_engine_context *)cc;
+    int r = omni_tls_run_until(eng, fd, BR_SSL_RECVAPP);
+    if (r <= 0) return r;
+    size_t avail;
+    unsigned char *buf = br_ssl_engine_recvapp_buf(eng, &avail);
+    if (avail > len) avail = len;
+    memcpy(out, buf, avail);
+    br_ssl_engine_recvapp_ack(eng, avail);
+    return (int)avail;
+}
+
+/* Queue up to len bytes of application data. >0 bytes taken, <0 = status. */
+int omni_tls_engine_write(void *cc, int fd, const unsigned char *data, size_t len) {
+    br_ssl_engine_context *eng = (br_ssl_engine_context *)cc;
+    int r = omni_tls_run_until(eng, fd, BR_SSL_SENDAPP);
+    if (r == 0) return OMNI_TLS_ERROR;
+    if (r < 0) return r;
+    size_t room;
+    unsigned char *buf = br_ssl_engine_sendapp_buf(eng, &room);
+    if (room > len) room = len;
+    memcpy(buf, data, room);
+    br_ssl_engine_sendapp_ack(eng, room);
+    return (int)room;
+}
+
+/* Flush queued application data onto the socket. 1 = done, <0 = status. */
+int omni_tls_engine_flush(void *cc, int fd) {
+    br_ssl_engine_context *eng = (br_ssl_engine_context *)cc;
+    br_ssl_engine_flush(eng, 0);
+    for (;;) {
+        unsigned state = br_ssl_engine_current_state(eng);
+        if (state & BR_SSL_CLOSED) return OMNI_TLS_ERROR;
+        if (!(state & BR_SSL_SENDREC)) return 1;
+        int r = omni_tls_send_records(eng, fd);
+        if (r < 0) return r;
+    }
+}
+
+/* Send close_notify without waiting for the peer's reply. */
+void omni_tls_engine_close(void *cc, int fd) {
+    br_ssl_engine_context *eng = (br_ssl_engine_context *)cc;
+    br_ssl_engine_close(eng);
+    while (br_ssl_engine_current_state(eng) & BR_SSL_SENDREC) {
+        if (omni_tls_send_records(eng, fd) < 0) break;
     }
 }
+
+/*
+ * Copy the engine's session parameters into out (sizeof br_ssl_session_parameters).
+ * Returns 1 when they describe a resumable session: a session ID was
+ * assigned and the engine has not failed.
+ */
+int omni_tls_session_get(void *cc, void *out) {
+    br_ssl_engine_context *eng = (br_ssl_engine_context *)cc;
+    br_ssl_session_parameters *pp = (br_ssl_session_parameters *)out;
+    br_ssl_engine_get_session_parameters(eng, pp);
+    return pp->session_id_len > 0 && br_ssl_engine_last_error(eng) == BR_ERR_OK;
+}
+
+/* Install cached session parameters before br_ssl_client_reset(.., 1). */
+void omni_tls_session_set(void *cc, const void *params) {
+    br_ssl_engine_set_session_parameters((br_ssl_engine_context *)cc,
+        (const br_ssl_session_parameters *)params);
+}
@@ -0,0 +1,8 @@
+/* Single translation unit for the vendored vmem arena implementation */
+
+#define VMEM_ARENA_IMPLEMENTATION
+/* mmap/mprotect failures return NULL instead of asserting. Every caller checks:
+   vmem-backed scopes fall back to malloc'd chunks, and a scratch json-parse
+   fails like any other out-of-memory parse. */
+#define VMEM_ARENA_ASSERT(cond) ((void)0)
+#include "../third_party/arena/vmem_arena.h"
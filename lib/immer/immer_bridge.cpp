@@ -9,10 +9,24 @@
 
 #include "immer_bridge.h"
 
+#include <immer/algorithm.hpp>
 #include <immer/flex_vector.hpp>
+#include <immer/flex_vector_transient.hpp>
 #include <immer/map.hpp>
+#include <immer/map_transient.hpp>
 #include <immer/set.hpp>
+#include <immer/set_transient.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <dlfcn.h>
 #include <functional>
+#include <mutex>
+#include <new>
+#include <utility>
 
 /*
  * We use void* as the element type for maximum flexibility.
@@ -21,38 +35,258 @@
  * We use flex_vector instead of vector because it supports both
  * take and drop operations efficiently.
  *
- * For maps and sets, we need comparison. We use pointer comparison
- * which works for interned symbols/keywords. For value equality,
- * a custom comparator would be needed.
+ * For maps and sets, we need comparison. IMap/ISet use pointer comparison
+ * which works for interned symbols/keywords. IValueMap/IValueSet store a
+ * ValueKey (pointer + cached hash) and compare through the value policy.
  */
 
+namespace {
+
+std::atomic<immer_hash_fn> g_value_hash{nullptr};
+std::atomic<immer_equal_fn> g_value_equal{nullptr};
+
+uint64_t identity_hash(void* v) {
+    return std::hash<void*>{}(v);
+}
+
+int identity_equal(void* a, void* b) {
+    return a == b;
+}
+
+// Resolve the Omni runtime's value hashing when no policy was installed.
+// Racing callers resolve the same symbols, so the duplicate store is benign.
+immer_hash_fn resolve_policy() {
+    auto hash = reinterpret_cast<immer_hash_fn>(dlsym(RTLD_DEFAULT, "omni_value_hash"));
+    auto equal = reinterpret_cast<immer_equal_fn>(dlsym(RTLD_DEFAULT, "omni_value_equal"));
+    if (hash == nullptr || equal == nullptr) {
+        hash = &identity_hash;
+        equal = &identity_equal;
+    }
+    g_value_equal.store(equal, std::memory_order_release);
+    g_value_hash.store(hash, std::memory_order_release);
+    return hash;
+}
+
+struct ValueKey {
+    void* value;
+    uint64_t hash;
+};
+
+ValueKey make_key(void* value) {
+    immer_hash_fn hash = g_value_hash.load(std::memory_order_acquire);
+    if (hash == nullptr) hash = resolve_policy();
+    return ValueKey{value, hash(value)};
+}
+
+struct ValueKeyHash {
+    size_t operator()(const ValueKey& k) const { return static_cast<size_t>(k.hash); }
+};
+
+struct ValueKeyEqual {
+    bool operator()(const ValueKey& a, const ValueKey& b) const {
+        if (a.value == b.value) return true;
+        if (a.hash != b.hash) return false;
+        return g_value_equal.load(std::memory_order_acquire)(a.value, b.value) != 0;
+    }
+};
+
+} // namespace
+
 using IVector = immer::flex_vector<void*>;
 using IMap = immer::map<void*, void*>;
 using ISet = immer::set<void*>;
+using IValueMap = immer::map<ValueKey, void*, ValueKeyHash, ValueKeyEqual>;
+using IValueSet = immer::set<ValueKey, ValueKeyHash, ValueKeyEqual>;
+
+using IVectorTransient = IVector::transient_type;
+using IMapTransient = IMap::transient_type;
+using ISetTransient = ISet::transient_type;
+
+/*
+ * Handle pool.
+ *
+ * Persistent collections live in fixed-size slots carved from slabs that
+ * are never returned to the OS, so a push/assoc reuses a freed slot instead
+ * of calling new, and long-running processes do not fragment the heap.
+ *
+ * A handle is (generation << 32 | slot index + 1), not a pointer. Releasing
+ * a slot bumps its generation, so a second release or a use after release
+ * is detected and treated as the empty collection instead of touching
+ * reused memory. This makes immer_handle_release safe to register as a
+ * scope destructor even when Lisp code also frees the handle explicitly.
+ *
+ * A live handle is never null. Callers read null as the empty collection,
+ * so running out of slots (MAX_SLABS, or no memory for a new slab) aborts
+ * instead of handing one out and silently dropping the collection.
+ */
+namespace {
+
+enum HandleKind : uint8_t { HK_FREE = 0, HK_VECTOR, HK_MAP, HK_SET, HK_VALUE_MAP, HK_VALUE_SET };
+
+constexpr size_t SLOT_BYTES = 64;
+constexpr uint32_t SLAB_SLOTS = 256;
+constexpr uint32_t MAX_SLABS = 65536;
+
+static_assert(sizeof(IVector) <= SLOT_BYTES, "IVector does not fit a handle slot");
+static_assert(sizeof(IMap) <= SLOT_BYTES, "IMap does not fit a handle slot");
+static_assert(sizeof(ISet) <= SLOT_BYTES, "ISet does not fit a handle slot");
+static_assert(sizeof(IValueMap) <= SLOT_BYTES, "IValueMap does not fit a handle slot");
+static_assert(sizeof(IValueSet) <= SLOT_BYTES, "IValueSet does not fit a handle slot");
+
+struct HandleSlot {
+    alignas(std::max_align_t) unsigned char storage[SLOT_BYTES];
+    std::atomic<uint32_t> gen{1};
+    HandleKind kind = HK_FREE;
+    uint32_t next_free = 0;  // index + 1 of the next free slot, 0 = none
+};
+
+std::atomic<HandleSlot*> g_slabs[MAX_SLABS];
+uint32_t g_slab_count = 0;
+uint32_t g_free_head = 0;
+size_t g_live = 0;
+std::mutex g_pool_lock;
+
+HandleSlot* slot_at(uint32_t idx) {
+    HandleSlot* slab = g_slabs[idx / SLAB_SLOTS].load(std::memory_order_acquire);
+    return slab ? &slab[idx % SLAB_SLOTS] : nullptr;
+}
+
+// Caller holds g_pool_lock
+bool grow_pool() {
+    if (g_slab_count >= MAX_SLABS) return false;
+    auto* slab = new (std::nothrow) HandleSlot[SLAB_SLOTS];
+    if (slab == nullptr) return false;
+    uint32_t base = g_slab_count * SLAB_SLOTS;
+    for (uint32_t i = 0; i < SLAB_SLOTS; i++) {
+        slab[i].next_free = (i + 1 < SLAB_SLOTS) ? base + i + 2 : g_free_head;
+    }
+    g_free_head = base + 1;
+    g_slabs[g_slab_count].store(slab, std::memory_order_release);
+    g_slab_count++;
+    return true;
+}
+
+HandleSlot* decode(void* h, uint32_t* idx_out) {
+    auto bits = reinterpret_cast<uintptr_t>(h);
+    auto idx1 = static_cast<uint32_t>(bits);
+    if (idx1 == 0) return nullptr;
+    uint32_t idx = idx1 - 1;
+    if (idx / SLAB_SLOTS >= MAX_SLABS) return nullptr;
+    HandleSlot* s = slot_at(idx);
+    if (s == nullptr || s->gen.load(std::memory_order_acquire) != static_cast<uint32_t>(bits >> 32)) {
+        return nullptr;
+    }
+    if (idx_out != nullptr) *idx_out = idx;
+    return s;
+}
+
+template <typename T>
+T* handle_get(void* h, HandleKind kind) {
+    HandleSlot* s = decode(h, nullptr);
+    if (s == nullptr || s->kind != kind) return nullptr;
+    return std::launder(reinterpret_cast<T*>(s->storage));
+}
+
+[[noreturn]] void pool_exhausted() {
+    std::fprintf(stderr, "immer_bridge: handle pool exhausted (%zu live handles)\n", g_live);
+    std::abort();
+}
+
+template <typename T>
+void* handle_new(HandleKind kind, T&& value) {
+    uint32_t idx;
+    HandleSlot* s;
+    {
+        std::lock_guard<std::mutex> guard(g_pool_lock);
+        if (g_free_head == 0 && !grow_pool()) pool_exhausted();
+        idx = g_free_head - 1;
+        s = slot_at(idx);
+        g_free_head = s->next_free;
+        g_live++;
+    }
+    new (s->storage) std::decay_t<T>(std::forward<T>(value));
+    s->kind = kind;
+    uint32_t gen = s->gen.load(std::memory_order_relaxed);
+    return reinterpret_cast<void*>((static_cast<uintptr_t>(gen) << 32) | (idx + 1));
+}
+
+void handle_release(void* h) {
+    std::lock_guard<std::mutex> guard(g_pool_lock);
+    uint32_t idx;
+    HandleSlot* s = decode(h, &idx);
+    if (s == nullptr || s->kind == HK_FREE) return;  // stale or double release
+    switch (s->kind) {
+        case HK_VECTOR: std::launder(reinterpret_cast<IVector*>(s->storage))->~IVector(); break;
+        case HK_MAP:    std::launder(reinterpret_cast<IMap*>(s->storage))->~IMap(); break;
+        case HK_SET:    std::launder(reinterpret_cast<ISet*>(s->storage))->~ISet(); break;
+        case HK_VALUE_MAP: std::launder(reinterpret_cast<IValueMap*>(s->storage))->~IValueMap(); break;
+        case HK_VALUE_SET: std::launder(reinterpret_cast<IValueSet*>(s->storage))->~IValueSet(); break;
+        default: break;
+    }
+    s->kind = HK_FREE;
+    s->gen.fetch_add(1, std::memory_order_release);
+    s->next_free = g_free_head;
+    g_free_head = idx + 1;
+    g_live--;
+}
+
+// Stale handles read as the empty collection
+const IVector g_empty_vector;
+const IMap g_empty_map;
+const ISet g_empty_set;
+const IValueMap g_empty_value_map;
+const IValueSet g_empty_value_set;
+
+const IVector* as_vector(void* h) {
+    auto* v = handle_get<IVector>(h, HK_VECTOR);
+    return v ? v : &g_empty_vector;
+}
+
+const IMap* as_map(void* h) {
+    auto* m = handle_get<IMap>(h, HK_MAP);
+    return m ? m : &g_empty_map;
+}
+
+const ISet* as_set(void* h) {
+    auto* s = handle_get<ISet>(h, HK_SET);
+    return s ? s : &g_empty_set;
+}
+
+const IValueMap* as_value_map(void* h) {
+    auto* m = handle_get<IValueMap>(h, HK_VALUE_MAP);
+    return m ? m : &g_empty_value_map;
+}
+
+const IValueSet* as_value_set(void* h) {
+    auto* s = handle_get<IValueSet>(h, HK_VALUE_SET);
+    return s ? s : &g_empty_value_set;
+}
+
+} // namespace
 
 extern "C" {
 
 /* ========== Vector ========== */
 
 void* immer_vector_empty(void) {
-    return new IVector();
+    return handle_new(HK_VECTOR, IVector());
 }
 
 void* immer_vector_push(void* vec, void* elem) {
-    auto* v = static_cast<IVector*>(vec);
-    return new IVector(v->push_back(elem));
+    auto* v = as_vector(vec);
+    return handle_new(HK_VECTOR, v->push_back(elem));
 }
 
 void* immer_vector_set(void* vec, int idx, void* elem) {
-    auto* v = static_cast<IVector*>(vec);
+    auto* v = as_vector(vec);
     if (idx < 0 || static_cast<size_t>(idx) >= v->size()) {
-        return vec;  // Return unchanged on out-of-bounds
+        return handle_new(HK_VECTOR, IVector(*v));  // Unchanged copy on out-of-bounds
     }
-    return new IVector(v->set(idx, elem));
+    return handle_new(HK_VECTOR, v->set(idx, elem));
 }
 
 void* immer_vector_get(void* vec, int idx) {
-    auto* v = static_cast<IVector*>(vec);
+    auto* v = as_vector(vec);
     if (idx < 0 || static_cast<size_t>(idx) >= v->size()) {
         return nullptr;
     }
@@ -60,44 +294,44 @@ void* immer_vector_get(void* vec, int idx) {
 }
 
 int immer_vector_size(void* vec) {
-    auto* v = static_cast<IVector*>(vec);
+    auto* v = as_vector(vec);
     return static_cast<int>(v->size());
 }
 
 void* immer_vector_pop(void* vec) {
-    auto* v = static_cast<IVector*>(vec);
+    auto* v = as_vector(vec);
     if (v->size() == 0) {
-        return vec;  // Return unchanged on empty
+        return handle_new(HK_VECTOR, IVector(*v));  // Unchanged copy on empty
     }
-    return new IVector(v->take(v->size() - 1));
+    return handle_new(HK_VECTOR, v->take(v->size() - 1));
 }
 
 void* immer_vector_take(void* vec, int n) {
-    auto* v = static_cast<IVector*>(vec);
+    auto* v = as_vector(vec);
     if (n <= 0) {
-        return new IVector();
+        return handle_new(HK_VECTOR, IVector());
     }
     size_t take_n = std::min(static_cast<size_t>(n), v->size());
-    return new IVector(v->take(take_n));
+    return handle_new(HK_VECTOR, v->take(take_n));
 }
 
 void* immer_vector_drop(void* vec, int n) {
-    auto* v = static_cast<IVector*>(vec);
+    auto* v = as_vector(vec);
     if (n <= 0) {
-        return new IVector(*v);  // Copy
+        return handle_new(HK_VECTOR, IVector(*v));  // Copy
     }
     if (static_cast<size_t>(n) >= v->size()) {
-        return new IVector();
+        return handle_new(HK_VECTOR, IVector());
     }
-    return new IVector(v->drop(n));
+    return handle_new(HK_VECTOR, v->drop(n));
 }
 
 void immer_vector_free(void* vec) {
-    delete static_cast<IVector*>(vec);
+    handle_release(vec);
 }
 
 void immer_vector_foreach(void* vec, immer_iter_fn fn, void* ctx) {
-    auto* v = static_cast<IVector*>(vec);
+    auto* v = as_vector(vec);
     for (auto& elem : *v) {
         if (fn(elem, ctx) != 0) {
             break;
@@ -105,44 +339,67 @@ void immer_vector_foreach(void* vec, immer_iter_fn fn, void* ctx) {
     }
 }
 
+void immer_vector_for_each_chunk(void* vec, immer_chunk_fn fn, void* ctx) {
+    auto* v = as_vector(vec);
+    bool stopped = false;
+    v->for_each_chunk([&](void* const* first, void* const* last) {
+        if (stopped) return;  // for_each_chunk has no early exit
+        stopped = fn(first, static_cast<size_t>(last - first), ctx) != 0;
+    });
+}
+
+int immer_vector_copy_range(void* vec, int start, int n, void** out) {
+    auto* v = as_vector(vec);
+    if (start < 0 || n <= 0 || static_cast<size_t>(start) >= v->size()) {
+        return 0;
+    }
+    size_t end = std::min(v->size(), static_cast<size_t>(start) + static_cast<size_t>(n));
+    void** dst = out;
+    immer::for_each_chunk(v->begin() + start, v->begin() + end,
+        [&](void* const* first, void* const* last) {
+            dst = std::copy(first, last, dst);
+        });
+    return static_cast<int>(dst - out);
+}
+
 /* ========== Map ========== */
 
 void* immer_map_empty(void) {
-    return new IMap();
+    return handle_new(HK_MAP, IMap());
 }
 
 void* immer_map_assoc(void* m, void* key, void* val) {
-    auto* map = static_cast<IMap*>(m);
-    return new IMap(map->set(key, val));
+    auto* map = as_map(m);
+    return handle_new(HK_MAP, map->set(key, val));
 }
 
 void* immer_map_get(void* m, void* key, void* not_found) {
-    auto* map = static_cast<IMap*>(m);
+    auto* map = as_map(m);
     auto* found = map->find(key);
     return found ? *found : not_found;
 }
 
 void* immer_map_dissoc(void* m, void* key) {
-    auto* map = static_cast<IMap*>(m);
-    return new IMap(map->erase(key));
+    auto* map = as_map(m);
+    return handle_new(HK_MAP, map->erase(key));
 }
 
 int immer_map_contains(void* m, void* key) {
-    auto* map = static_cast<IMap*>(m);
+    auto* map = as_map(m);
     return map->count(key) > 0 ? 1 : 0;
 }
 
 int immer_map_count(void* m) {
-    auto* map = static_cast<IMap*>(m);
+    auto* map = as_map(m);
     return static_cast<int>(map->size());
 }
 
 void immer_map_free(void* m) {
-    delete static_cast<IMap*>(m);
+    handle_release(m);
 }
 
 void immer_map_foreach(void* m, immer_iter_kv_fn fn, void* ctx) {
-    auto* map = static_cast<IMap*>(m);
+    auto* map = as_map(m);
     for (auto& [key, val] : *map) {
         if (fn(key, val, ctx) != 0) {
             break;
@@ -153,35 +410,35 @@ void immer_map_foreach(void* m, immer_iter_kv_fn fn, void* ctx) {
 /* ========== Set ========== */
 
 void* immer_set_empty(void) {
-    return new ISet();
+    return handle_new(HK_SET, ISet());
 }
 
 void* immer_set_conj(void* s, void* elem) {
-    auto* set = static_cast<ISet*>(s);
-    return new ISet(set->insert(elem));
+    auto* set = as_set(s);
+    return handle_new(HK_SET, set->insert(elem));
 }
 
 void* immer_set_disj(void* s, void* elem) {
-    auto* set = static_cast<ISet*>(s);
-    return new ISet(set->erase(elem));
+    auto* set = as_set(s);
+    return handle_new(HK_SET, set->erase(elem));
 }
 
 int immer_set_contains(void* s, void* elem) {
-    auto* set = static_cast<ISet*>(s);
+    auto* set = as_set(s);
     return set->count(elem) > 0 ? 1 : 0;
 }
 
 int immer_set_count(void* s) {
-    auto* set = static_cast<ISet*>(s);
+    auto* set = as_set(s);
     return static_cast<int>(set->size());
 }
 
 void immer_set_free(void* s) {
-    delete static_cast<ISet*>(s);
+    handle_release(s);
 }
 
 void immer_set_foreach(void* s, immer_iter_fn fn, void* ctx) {
-    auto* set = static_cast<ISet*>(s);
+    auto* set = as_set(s);
     for (auto& elem : *set) {
         if (fn(elem, ctx) != 0) {
             break;
@@ -189,4 +446,202 @@ void immer_set_foreach(void* s, immer_iter_fn fn, void* ctx) {
     }
 }
 
+/* ========== Value-keyed Map and Set ========== */
+
+void immer_value_policy(immer_hash_fn hash, immer_equal_fn equal) {
+    if (hash == nullptr || equal == nullptr) {
+        g_value_hash.store(nullptr, std::memory_order_release);  // re-resolve on next use
+        return;
+    }
+    g_value_equal.store(equal, std::memory_order_release);
+    g_value_hash.store(hash, std::memory_order_release);
+}
+
+void* immer_value_map_empty(void) {
+    return handle_new(HK_VALUE_MAP, IValueMap());
+}
+
+void* immer_value_map_assoc(void* m, void* key, void* val) {
+    auto* map = as_value_map(m);
+    return handle_new(HK_VALUE_MAP, map->set(make_key(key), val));
+}
+
+void* immer_value_map_get(void* m, void* key, void* not_found) {
+    auto* map = as_value_map(m);
+    auto* found = map->find(make_key(key));
+    return found ? *found : not_found;
+}
+
+void* immer_value_map_dissoc(void* m, void* key) {
+    auto* map = as_value_map(m);
+    return handle_new(HK_VALUE_MAP, map->erase(make_key(key)));
+}
+
+int immer_value_map_contains(void* m, void* key) {
+    auto* map = as_value_map(m);
+    return map->count(make_key(key)) > 0 ? 1 : 0;
+}
+
+int immer_value_map_count(void* m) {
+    auto* map = as_value_map(m);
+    return static_cast<int>(map->size());
+}
+
+void immer_value_map_free(void* m) {
+    handle_release(m);
+}
+
+void immer_value_map_foreach(void* m, immer_iter_kv_fn fn, void* ctx) {
+    auto* map = as_value_map(m);
+    for (auto& [key, val] : *map) {
+        if (fn(key.value, val, ctx) != 0) {
+            break;
+        }
+    }
+}
+
+void* immer_value_set_empty(void) {
+    return handle_new(HK_VALUE_SET, IValueSet());
+}
+
+void* immer_value_set_conj(void* s, void* elem) {
+    auto* set = as_value_set(s);
+    return handle_new(HK_VALUE_SET, set->insert(make_key(elem)));
+}
+
+void* immer_value_set_disj(void* s, void* elem) {
+    auto* set = as_value_set(s);
+    return handle_new(HK_VALUE_SET, set->erase(make_key(elem)));
+}
+
+int immer_value_set_contains(void* s, void* elem) {
+    auto* set = as_value_set(s);
+    return set->count(make_key(elem)) > 0 ? 1 : 0;
+}
+
+int immer_value_set_count(void* s) {
+    auto* set = as_value_set(s);
+    return static_cast<int>(set->size());
+}
+
+void immer_value_set_free(void* s) {
+    handle_release(s);
+}
+
+void immer_value_set_foreach(void* s, immer_iter_fn fn, void* ctx) {
+    auto* set = as_value_set(s);
+    for (auto& elem : *set) {
+        if (fn(elem.value, ctx) != 0) {
+            break;
+        }
+    }
+}
+
+/* ========== Transients ========== */
+
+void* immer_vector_transient(void* vec) {
+    if (vec == nullptr) {
+        return new IVectorTransient();
+    }
+    return new IVectorTransient(as_vector(vec)->transient());
+}
+
+void immer_transient_push_back(void* t, void* elem) {
+    static_cast<IVectorTransient*>(t)->push_back(elem);
+}
+
+void immer_transient_set(void* t, int idx, void* elem) {
+    auto* tv = static_cast<IVectorTransient*>(t);
+    if (idx < 0 || static_cast<size_t>(idx) >= tv->size()) {
+        return;  // Ignore out-of-bounds, like immer_vector_set
+    }
+    tv->set(idx, elem);
+}
+
+int immer_transient_size(void* t) {
+    return static_cast<int>(static_cast<IVectorTransient*>(t)->size());
+}
+
+void* immer_transient_persistent(void* t) {
+    auto* tv = static_cast<IVectorTransient*>(t);
+    void* v = handle_new(HK_VECTOR, std::move(*tv).persistent());
+    delete tv;
+    return v;
+}
+
+void immer_transient_free(void* t) {
+    delete static_cast<IVectorTransient*>(t);
+}
+
+void* immer_map_transient(void* m) {
+    if (m == nullptr) {
+        return new IMapTransient();
+    }
+    return new IMapTransient(as_map(m)->transient());
+}
+
+void immer_map_transient_assoc(void* t, void* key, void* val) {
+    static_cast<IMapTransient*>(t)->set(key, val);
+}
+
+void immer_map_transient_dissoc(void* t, void* key) {
+    static_cast<IMapTransient*>(t)->erase(key);
+}
+
+int immer_map_transient_count(void* t) {
+    return static_cast<int>(static_cast<IMapTransient*>(t)->size());
+}
+
+void* immer_map_transient_persistent(void* t) {
+    auto* tm = static_cast<IMapTransient*>(t);
+    void* m = handle_new(HK_MAP, std::move(*tm).persistent());
+    delete tm;
+    return m;
+}
+
+void immer_map_transient_free(void* t) {
+    delete static_cast<IMapTransient*>(t);
+}
+
+void* immer_set_transient(void* s) {
+    if (s == nullptr) {
+        return new ISetTransient();
+    }
+    return new ISetTransient(as_set(s)->transient());
+}
+
+void immer_set_transient_conj(void* t, void* elem) {
+    static_cast<ISetTransient*>(t)->insert(elem);
+}
+
+void immer_set_transient_disj(void* t, void* elem) {
+    static_cast<ISetTransient*>(t)->erase(elem);
+}
+
+int immer_set_transient_count(void* t) {
+    return static_cast<int>(static_cast<ISetTransient*>(t)->size());
+}
+
+void* immer_set_transient_persistent(void* t) {
+    auto* ts = static_cast<ISetTransient*>(t);
+    void* s = handle_new(HK_SET, std::move(*ts).persistent());
+    delete ts;
+    return s;
+}
+
+void immer_set_transient_free(void* t) {
+    delete static_cast<ISetTransient*>(t);
+}
+
+/* ========== Handle Management ========== */
+
+void immer_handle_release(void* h) {
+    handle_release(h);
+}
+
+int immer_handle_live(void) {
+    std::lock_guard<std::mutex> guard(g_pool_lock);
+    return static_cast<int>(g_live);
+}
+
 } /* extern "C" */
@@ -5,12 +5,24 @@
  * for use with OmniLisp's FFI mechanism.
  *
  * All functions use void* for opaque handles to Immer structures.
- * Memory management: caller must call *_free() when done.
+ * Handles are slots in a pooled slab allocator (no new/delete per
+ * operation), encoded as slot index + generation rather than pointers.
+ * Every operation returns a distinct, non-null handle; if the pool
+ * cannot grow, the process aborts rather than return NULL.
+ *
+ * Memory management: release a handle with *_free() or
+ * immer_handle_release(). Releasing twice, or using a released handle,
+ * is safe: a stale handle reads as the empty collection. Because of that,
+ * immer_handle_release can be registered as a ScopeRegion destructor
+ * (the ^(Owned immer_handle_release) FFI return annotation does this).
  */
 
 #ifndef IMMER_BRIDGE_H
 #define IMMER_BRIDGE_H
 
+#include <stddef.h>
+#include <stdint.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -87,6 +99,88 @@ int immer_set_count(void* s);
 /* Free set */
 void immer_set_free(void* s);
 
+/* ========== Value-keyed Map and Set ========== */
+
+/*
+ * The plain map/set above compare keys by pointer identity, which only
+ * works for interned symbols. The value_map/value_set variants hash and
+ * compare through a policy of two callbacks, so strings and numbers built
+ * at runtime find each other. Each stored key keeps its hash, so it is
+ * never recomputed when the trie is rebalanced, and equality is only
+ * called when the hashes match.
+ *
+ * The policy is process-wide and must be installed before the first value
+ * map or set is created. If none is installed, the bridge looks up
+ * omni_value_hash / omni_value_equal exported by the Omni runtime, and
+ * falls back to identity if they are not found.
+ */
+
+typedef uint64_t (*immer_hash_fn)(void* value);
+typedef int (*immer_equal_fn)(void* a, void* b);  /* non-zero = equal */
+
+/* Install the hash/equality policy (NULL restores the default lookup) */
+void immer_value_policy(immer_hash_fn hash, immer_equal_fn equal);
+
+/* Value-keyed map: same semantics as immer_map_* */
+void* immer_value_map_empty(void);
+void* immer_value_map_assoc(void* m, void* key, void* val);
+void* immer_value_map_get(void* m, void* key, void* not_found);
+void* immer_value_map_dissoc(void* m, void* key);
+int immer_value_map_contains(void* m, void* key);
+int immer_value_map_count(void* m);
+void immer_value_map_free(void* m);
+
+/* Value-keyed set: same semantics as immer_set_* */
+void* immer_value_set_empty(void);
+void* immer_value_set_conj(void* s, void* elem);
+void* immer_value_set_disj(void* s, void* elem);
+int immer_value_set_contains(void* s, void* elem);
+int immer_value_set_count(void* s);
+void immer_value_set_free(void* s);
+
+/* ========== Transients (batch-mutable builders) ========== */
+
+/*
+ * A transient is a mutable builder over a persistent collection. Updates
+ * happen in place (no new wrapper, no path copy per element), and
+ * *_persistent() turns it back into a persistent collection in O(1).
+ * The *_persistent() call consumes the transient: do not use or free it
+ * afterwards. Pass NULL as the source to start from an empty collection.
+ * Use *_free() only to abandon a transient without converting it.
+ */
+
+/* Vector transient */
+void* immer_vector_transient(void* vec);
+void immer_transient_push_back(void* t, void* elem);
+void immer_transient_set(void* t, int idx, void* elem);
+int immer_transient_size(void* t);
+void* immer_transient_persistent(void* t);  /* returns NEW vector */
+void immer_transient_free(void* t);
+
+/* Map transient */
+void* immer_map_transient(void* m);
+void immer_map_transient_assoc(void* t, void* key, void* val);
+void immer_map_transient_dissoc(void* t, void* key);
+int immer_map_transient_count(void* t);
+void* immer_map_transient_persistent(void* t);  /* returns NEW map */
+void immer_map_transient_free(void* t);
+
+/* Set transient */
+void* immer_set_transient(void* s);
+void immer_set_transient_conj(void* t, void* elem);
+void immer_set_transient_disj(void* t, void* elem);
+int immer_set_transient_count(void* t);
+void* immer_set_transient_persistent(void* t);  /* returns NEW set */
+void immer_set_transient_free(void* t);
+
+/* ========== Handle Management ========== */
+
+/* Release any vector/map/set handle (void(void*), usable as a scope dtor) */
+void immer_handle_release(void* h);
+
+/* Number of live (unreleased) handles in the pool */
+int immer_handle_live(void);
+
 /* ========== Iteration Support ========== */
 
 /*
@@ -101,12 +195,31 @@ typedef int (*immer_iter_kv_fn)(void* key, void* val, void* ctx);
 /* Iterate over vector elements */
 void immer_vector_foreach(void* vec, immer_iter_fn fn, void* ctx);
 
+/*
+ * Chunked iteration: the callback receives each contiguous leaf span
+ * (up to 32 elements) instead of one element, so a sum or map runs a
+ * tight loop over plain memory. Return 0 to continue, non-zero to stop.
+ */
+typedef int (*immer_chunk_fn)(void* const* data, size_t len, void* ctx);
+void immer_vector_for_each_chunk(void* vec, immer_chunk_fn fn, void* ctx);
+
+/*
+ * Copy up to n elements starting at start into out (caller-sized, n slots).
+ * Leaves are copied whole, so this is one trie descent per 32 elements
+ * rather than one per index. Returns the number of elements copied.
+ */
+int immer_vector_copy_range(void* vec, int start, int n, void** out);
+
 /* Iterate over map key-value pairs */
 void immer_map_foreach(void* m, immer_iter_kv_fn fn, void* ctx);
 
 /* Iterate over set elements */
 void immer_set_foreach(void* s, immer_iter_fn fn, void* ctx);
 
+/* Iterate over value-keyed map pairs / set elements */
+void immer_value_map_foreach(void* m, immer_iter_kv_fn fn, void* ctx);
+void immer_value_set_foreach(void* s, immer_iter_fn fn, void* ctx);
+
 #ifdef __cplusplus
 }
 #endif
@@ -1,11 +1,116 @@
 /*
  * test_bridge.cpp - Test the Immer bridge
+ *
+ * ./test_bridge              run the checks
+ * ./test_bridge --bench [n]  time the bridge entry points (make bench)
  */
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
 #include "immer_bridge.h"
 
-int main() {
+// Value policy over C strings: content hash and strcmp equality
+static uint64_t str_hash(void* v) {
+    uint64_t h = 1469598103934665603ull;
+    for (const char* p = (const char*)v; *p; p++) { h ^= (unsigned char)*p; h *= 1099511628211ull; }
+    return h;
+}
+
+static int str_equal(void* a, void* b) {
+    return strcmp((const char*)a, (const char*)b) == 0;
+}
+
+static double now_sec() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static void report(const char* name, long ops, double secs) {
+    printf("  %-28s %10.2f Mops/s  (%6.1f ns/op)\n",
+           name, (double)ops / secs / 1e6, secs * 1e9 / (double)ops);
+}
+
+// Key/value n as a pointer (maps hash and compare pointers by identity)
+static void* as_ptr(long n) { return (void*)(uintptr_t)(n + 1); }
+
+// Every persistent op returns a new handle; the old one is freed right away,
+// as the C3 side does when a collection value dies.
+static int run_bench(long n) {
+    printf("Immer bridge benchmarks (n=%ld)\n\n", n);
+    uintptr_t sink = 0;
+
+    double t0 = now_sec();
+    void* v = immer_vector_empty();
+    for (long i = 0; i < n; i++) {
+        void* next = immer_vector_push(v, as_ptr(i));
+        immer_vector_free(v);
+        v = next;
+    }
+    report("vector push", n, now_sec() - t0);
+
+    t0 = now_sec();
+    for (long i = 0; i < n; i++) sink += (uintptr_t)immer_vector_get(v, (int)((i * 7919) % n));
+    report("vector get", n, now_sec() - t0);
+
+    t0 = now_sec();
+    for (long i = 0; i < n; i++) {
+        void* next = immer_vector_set(v, (int)((i * 7919) % n), as_ptr(i));
+        immer_vector_free(v);
+        v = next;
+    }
+    report("vector set", n, now_sec() - t0);
+    immer_vector_free(v);
+
+    t0 = now_sec();
+    void* empty = immer_vector_empty();
+    void* t = immer_vector_transient(empty);
+    for (long i = 0; i < n; i++) immer_transient_push_back(t, as_ptr(i));
+    v = immer_transient_persistent(t);
+    report("transient push_back", n, now_sec() - t0);
+    sink += (uintptr_t)immer_vector_size(v);
+    immer_transient_free(t);
+    immer_vector_free(empty);
+    immer_vector_free(v);
+
+    t0 = now_sec();
+    void* m = immer_map_empty();
+    for (long i = 0; i < n; i++) {
+        void* next = immer_map_assoc(m, as_ptr(i), as_ptr(i));
+        immer_map_free(m);
+        m = next;
+    }
+    report("map assoc", n, now_sec() - t0);
+
+    t0 = now_sec();
+    for (long i = 0; i < n; i++) sink += (uintptr_t)immer_map_get(m, as_ptr((i * 7919) % n), NULL);
+    report("map get", n, now_sec() - t0);
+    immer_map_free(m);
+
+    t0 = now_sec();
+    m = immer_map_empty();
+    t = immer_map_transient(m);
+    for (long i = 0; i < n; i++) immer_map_transient_assoc(t, as_ptr(i), as_ptr(i));
+    void* built = immer_map_transient_persistent(t);
+    report("transient map assoc", n, now_sec() - t0);
+    sink += (uintptr_t)immer_map_count(built);
+    immer_map_transient_free(t);
+    immer_map_free(m);
+    immer_map_free(built);
+
+    printf("\n  live handles after run: %d  (checksum %lu)\n", immer_handle_live(), (unsigned long)sink);
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1 && strcmp(argv[1], "--bench") == 0) {
+        long n = argc > 2 ? atol(argv[2]) : 100000;
+        return run_bench(n > 0 ? n : 100000);
+    }
+
     printf("Testing Immer bridge...\n");
 
     // Test vector
@@ -104,6 +209,111 @@ int main() {
     immer_set_free(s4);
     immer_set_free(s5);
 
+    // Test transients
+    printf("\n=== Transient Tests ===\n");
+    int items[1000];
+    void* tv = immer_vector_transient(NULL);
+    for (int i = 0; i < 1000; i++) {
+        items[i] = i;
+        immer_transient_push_back(tv, &items[i]);
+    }
+    immer_transient_set(tv, 0, &items[999]);
+    printf("Transient size: %d (expected 1000)\n", immer_transient_size(tv));
+    void* tv_out = immer_transient_persistent(tv);
+    printf("Persistent size: %d (expected 1000)\n", immer_vector_size(tv_out));
+    got = (int*)immer_vector_get(tv_out, 500);
+    printf("tv_out[500] = %d (expected 500)\n", *got);
+    got = (int*)immer_vector_get(tv_out, 0);
+    printf("tv_out[0] = %d (expected 999)\n", *got);
+
+    // Transient from an existing vector leaves the source untouched
+    void* tv2 = immer_vector_transient(tv_out);
+    immer_transient_push_back(tv2, &items[1]);
+    void* tv2_out = immer_transient_persistent(tv2);
+    printf("Extended size: %d (expected 1001), source: %d (expected 1000)\n",
+           immer_vector_size(tv2_out), immer_vector_size(tv_out));
+    immer_vector_free(tv_out);
+    immer_vector_free(tv2_out);
+
+    void* tm = immer_map_transient(NULL);
+    immer_map_transient_assoc(tm, (void*)k1, &v_foo);
+    immer_map_transient_assoc(tm, (void*)k2, &v_bar);
+    immer_map_transient_dissoc(tm, (void*)k2);
+    printf("Map transient count: %d (expected 1)\n", immer_map_transient_count(tm));
+    void* tm_out = immer_map_transient_persistent(tm);
+    printf("Contains 'foo': %d (expected 1)\n", immer_map_contains(tm_out, (void*)k1));
+    immer_map_free(tm_out);
+
+    void* ts = immer_set_transient(NULL);
+    immer_set_transient_conj(ts, &e1);
+    immer_set_transient_conj(ts, &e2);
+    immer_set_transient_conj(ts, &e1);  // Duplicate
+    printf("Set transient count: %d (expected 2)\n", immer_set_transient_count(ts));
+    void* ts_out = immer_set_transient_persistent(ts);
+    printf("Contains e2: %d (expected 1)\n", immer_set_contains(ts_out, &e2));
+    immer_set_free(ts_out);
+
+    // Test chunked iteration and range copy
+    printf("\n=== Chunk Tests ===\n");
+    static long nums[100];
+    void* tc = immer_vector_transient(NULL);
+    for (int i = 0; i < 100; i++) { nums[i] = i; immer_transient_push_back(tc, &nums[i]); }
+    void* big = immer_transient_persistent(tc);
+    long chunk_sum = 0;
+    immer_vector_for_each_chunk(big, [](void* const* data, size_t len, void* ctx) -> int {
+        for (size_t i = 0; i < len; i++) *(long*)ctx += *(long*)data[i];
+        return 0;
+    }, &chunk_sum);
+    printf("Chunk sum: %ld (expected 4950)\n", chunk_sum);
+    void* window[40];
+    int copied = immer_vector_copy_range(big, 30, 40, window);
+    printf("Copied %d (expected 40), first=%ld last=%ld (expected 30 69)\n",
+           copied, *(long*)window[0], *(long*)window[39]);
+    printf("Copy past end: %d (expected 5)\n", immer_vector_copy_range(big, 95, 40, window));
+    immer_vector_free(big);
+
+    // Test value-keyed map and set
+    printf("\n=== Value Map/Set Tests ===\n");
+    immer_value_policy(str_hash, str_equal);
+    char alpha[] = "alpha", alpha_copy[] = "alpha", beta[] = "beta";
+    void* vm = immer_value_map_empty();
+    void* vm1 = immer_value_map_assoc(vm, alpha, &a);
+    void* vm2 = immer_value_map_assoc(vm1, beta, &b);
+    void* vm3 = immer_value_map_assoc(vm2, alpha_copy, &c);  // Replaces "alpha"
+    printf("Lookup by equal key: %d (expected 10)\n", *(int*)immer_value_map_get(vm2, alpha_copy, NULL));
+    printf("Value map count after re-assoc: %d (expected 2)\n", immer_value_map_count(vm3));
+    printf("Contains copy of key: %d (expected 1)\n", immer_value_map_contains(vm3, alpha_copy));
+    void* vm4 = immer_value_map_dissoc(vm3, alpha_copy);
+    printf("After dissoc by equal key: %d (expected 1)\n", immer_value_map_count(vm4));
+
+    char e_copy[] = "beta";
+    void* vs0 = immer_value_set_empty();
+    void* vs = immer_value_set_conj(vs0, beta);
+    void* vs1 = immer_value_set_conj(vs, e_copy);  // Duplicate by value
+    printf("Value set count: %d (expected 1)\n", immer_value_set_count(vs1));
+    printf("Value set contains: %d (expected 1)\n", immer_value_set_contains(vs1, e_copy));
+    immer_value_map_free(vm); immer_value_map_free(vm1); immer_value_map_free(vm2);
+    immer_value_map_free(vm3); immer_value_map_free(vm4);
+    immer_value_set_free(vs0); immer_value_set_free(vs); immer_value_set_free(vs1);
+
+    // Test handle pool
+    printf("\n=== Handle Pool Tests ===\n");
+    int live_before = immer_handle_live();
+    void* h0 = immer_vector_empty();
+    void* h1 = immer_vector_push(h0, &a);
+    void* h2 = immer_vector_set(h1, 99, &b);  // Out of bounds: distinct copy
+    printf("Out-of-bounds set returns new handle: %d (expected 1)\n", h1 != h2);
+    immer_handle_release(h1);
+    immer_handle_release(h1);  // Double release is a no-op
+    printf("Stale handle size: %d (expected 0)\n", immer_vector_size(h1));
+    printf("Copy survives: size=%d (expected 1)\n", immer_vector_size(h2));
+    void* h3 = immer_vector_empty();  // Reuses h1's slot with a new generation
+    printf("Reused slot is a new handle: %d (expected 1)\n", h3 != h1);
+    immer_vector_free(h0);
+    immer_vector_free(h2);
+    immer_vector_free(h3);
+    printf("Live handles: %d (expected %d)\n", immer_handle_live(), live_before);
+
     printf("\n=== All Tests Passed ===\n");
     return 0;
 }
@@ -0,0 +1,163 @@
+#!/bin/bash
+# bench.sh — run the tests/bench_*.omni scripts and report wall-time
+# percentiles and scope allocations per op as JSON.
+#
+# Every repetition is a fresh interpreter process, so numbers include
+# startup; an empty script is timed first as the startup baseline and
+# subtracted in ns_per_op. Each script declares its op count with a
+# ";; bench-ops: N" line (default 1). Allocation counts come from the final
+# [memory-stats] line the interpreter prints at exit under OMNI_MEMSTATS_DUMP.
+#
+# Usage:
+#   scripts/bench.sh [options] [script.omni ...]
+#
+#   -w N          warmup runs per script, not recorded (default 2)
+#   -n N          recorded runs per script (default 10)
+#   -o FILE       JSON output (default build/bench.json)
+#   -i IMAGE      start each run from a prelude image (--image)
+#   --perf        also record each script under perf with JIT symbols
+#                 (OMNI_PERF_MAP=1 writes /tmp/perf-<pid>.map)
+#   --native      also run the native microbenchmarks (omni --bench-native,
+#                 bench/ and lib/immer/)
+#
+# Environment:
+#   OMNI=path     interpreter binary (default ./build/main)
+#   BENCH_CPU=N   pin runs to one CPU with taskset
+
+set -e
+
+cd "$(dirname "$0")/.."
+
+OMNI=${OMNI:-./build/main}
+WARMUP=2
+REPS=10
+OUT=build/bench.json
+IMAGE=
+PERF=0
+NATIVE=0
+SCRIPTS=()
+
+while [ $# -gt 0 ]; do
+    case "$1" in
+        -w) WARMUP=$2; shift 2 ;;
+        -n) REPS=$2; shift 2 ;;
+        -o) OUT=$2; shift 2 ;;
+        -i) IMAGE=$2; shift 2 ;;
+        --perf) PERF=1; shift ;;
+        --native) NATIVE=1; shift ;;
+        -h|--help) awk 'NR > 1 && /^#/ { sub(/^# ?/, ""); print; next } NR > 1 { exit }' "$0"; exit 0 ;;
+        *) SCRIPTS+=("$1"); shift ;;
+    esac
+done
+
+if [ ${#SCRIPTS[@]} -eq 0 ]; then
+    SCRIPTS=(tests/bench_numeric.omni tests/bench_runtime.omni
+             tests/bench_simple.omni tests/bench_specialization.omni)
+fi
+if [ ! -x "$OMNI" ]; then
+    echo "bench.sh: $OMNI not found (build with c3c build, or set OMNI)" >&2
+    exit 1
+fi
+if [ "$REPS" -lt 1 ]; then
+    echo "bench.sh: -n must be at least 1" >&2
+    exit 1
+fi
+
+export LC_ALL=C
+export LD_LIBRARY_PATH=/usr/local/lib${LD_LIBRARY_PATH:+:$LD_LIBRARY_PATH}
+
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+mkdir -p "$(dirname "$OUT")"
+
+RUN=("$OMNI")
+if [ -n "$IMAGE" ]; then RUN+=(--image "$IMAGE"); fi
+PIN=()
+if [ -n "$BENCH_CPU" ]; then PIN=(taskset -c "$BENCH_CPU"); fi
+
+# run_once SCRIPT -> prints "wall_ns allocs alloc_bytes status"
+run_once() {
+    local start end status=0 stats
+    start=$(date +%s%N)
+    OMNI_MEMSTATS_DUMP=86400000 "${PIN[@]}" "${RUN[@]}" "$1" > /dev/null 2> "$WORK/stderr" || status=$?
+    end=$(date +%s%N)
+    stats=$(grep '^\[memory-stats\] live=' "$WORK/stderr" | tail -n 1 |
+            sed -n 's/.* allocs=\([0-9]*\)\/\([0-9]*\)B.*/\1 \2/p')
+    echo "$((end - start)) ${stats:-0 0} $status"
+}
+
+# bench_script NAME SCRIPT BASELINE_NS -> appends one JSON object to $WORK/results
+bench_script() {
+    local name=$1 script=$2 baseline=$3 ops line allocs=0 bytes=0 failed=0
+    ops=$(sed -n 's/^;; bench-ops: *\([0-9]*\).*/\1/p' "$script" | head -n 1)
+    ops=${ops:-1}
+    for ((i = 0; i < WARMUP; i++)); do run_once "$script" > /dev/null; done
+    : > "$WORK/times"
+    for ((i = 0; i < REPS; i++)); do
+        line=($(run_once "$script"))
+        echo "${line[0]}" >> "$WORK/times"
+        allocs=${line[1]}
+        bytes=${line[2]}
+        if [ "${line[3]}" != 0 ]; then failed=${line[3]}; fi
+    done
+    sort -n "$WORK/times" | awk -v name="$name" -v script="$script" -v ops="$ops" \
+        -v allocs="$allocs" -v bytes="$bytes" -v failed="$failed" -v base="$baseline" '
+        function pct(p,   k) { k = int((p * NR + 99) / 100); if (k < 1) k = 1; return t[k] }
+        { t[NR] = $1; sum += $1 }
+        END {
+            p50 = pct(50); net = p50 - base; if (net < 0) net = 0
+            printf "    {\"name\": \"%s\", \"script\": \"%s\", \"ok\": %s, \"exit_status\": %d,\n", name, script, failed == 0 ? "true" : "false", failed
+            printf "     \"ops\": %d, \"reps\": %d,\n", ops, NR
+            printf "     \"wall_ns\": {\"min\": %d, \"p50\": %d, \"p90\": %d, \"p99\": %d, \"max\": %d, \"mean\": %d},\n", t[1], p50, pct(90), pct(99), t[NR], sum / NR
+            printf "     \"ns_per_op\": %.1f, \"allocs\": %d, \"alloc_bytes\": %d, \"allocs_per_op\": %.3f, \"bytes_per_op\": %.1f}", net / ops, allocs, bytes, allocs / ops, bytes / ops
+        }' >> "$WORK/results"
+    awk -v name="$name" '{ t[NR] = $1 } END { printf "  %-28s p50 %8.2f ms  p90 %8.2f ms  (%d runs)\n", name, t[int((NR + 1) / 2)] / 1e6, t[int((9 * NR + 9) / 10)] / 1e6, NR }' \
+        <(sort -n "$WORK/times")
+    if [ "$failed" != 0 ]; then
+        echo "    exited with status $failed:" >&2
+        head -n 5 "$WORK/stderr" >&2
+    fi
+}
+
+echo "omni benchmarks: $WARMUP warmup + $REPS runs per script"
+echo ";; bench-ops: 1" > "$WORK/startup.omni"
+: > "$WORK/results"
+bench_script startup "$WORK/startup.omni" 0
+BASELINE=$(sort -n "$WORK/times" | awk '{ t[NR] = $1 } END { print t[int((NR + 1) / 2)] }')
+for script in "${SCRIPTS[@]}"; do
+    printf ',\n' >> "$WORK/results"
+    bench_script "$(basename "$script" .omni)" "$script" "$BASELINE"
+done
+
+{
+    printf '{\n  "commit": "%s",\n' "$(git rev-parse --short HEAD 2>/dev/null || echo unknown)"
+    printf '  "date": "%s",\n' "$(date -u +%Y-%m-%dT%H:%M:%SZ)"
+    printf '  "host": "%s",\n' "$(uname -srm)"
+    printf '  "omni": "%s", "image": "%s", "warmup": %d, "reps": %d,\n' "$OMNI" "$IMAGE" "$WARMUP" "$REPS"
+    printf '  "results": [\n'
+    cat "$WORK/results"
+    printf '\n  ]\n}\n'
+} > "$OUT"
+echo "wrote $OUT"
+
+if [ "$PERF" = 1 ]; then
+    if ! command -v perf > /dev/null; then
+        echo "bench.sh: perf not installed, skipping --perf" >&2
+    else
+        mkdir -p build/perf
+        for script in "${SCRIPTS[@]}"; do
+            data=build/perf/$(basename "$script" .omni).data
+            OMNI_PERF_MAP=1 "${PIN[@]}" perf record -q -g -o "$data" -- "${RUN[@]}" "$script" > /dev/null
+            echo "  perf report -i $data"
+        done
+    fi
+fi
+
+if [ "$NATIVE" = 1 ]; then
+    echo ""
+    "${PIN[@]}" "$OMNI" --bench-native
+    echo ""
+    make -s -C bench ffi json mathutils
+    echo ""
+    make -s -C lib/immer bench
+fi
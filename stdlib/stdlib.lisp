@@ -32,6 +32,8 @@
 (define [macro] when ([test .. body] (if test (begin .. body) nil)))
 (define [macro] unless ([test .. body] (if test nil (begin .. body))))
 (define [macro] cond ([] nil) ([test body .. rest] (if test body (cond .. rest))))
+;; deduce-batch: (deduce-batch db body...) — run body in one LMDB write txn
+(define [macro] deduce-batch ([db .. body] (__deduce-batch db (lambda () (begin .. body)))))
 (define with-trampoline (lambda (thunk) (handle (thunk nil) (bounce next-thunk (resolve (with-trampoline next-thunk))))))
 
 ;; =========================================================================
@@ -207,6 +209,8 @@
 
 ;; ifoldl: eagerly fold an iterator
 (define (ifoldl f acc it) (let loop (a acc cur it) (let (pair (next cur)) (if (null? pair) a (loop (f a (car pair)) (cdr pair))))))
+;; re-iter: lazy iterator over the non-overlapping matches of pattern in input
+(define (re-iter pattern input) (let step (pos 0) (make-iterator (lambda () (let (m (__re-next pattern input pos)) (if (null? m) nil (cons (car m) (step (cdr m)))))))))
 
 ;; =========================================================================
 ;; I/O Effect Wrappers